@@ -6,15 +6,151 @@
 std::FILE			* IDebugLog::logFile = NULL;
 char				IDebugLog::sourceBuf[16] = { 0 };
 char				IDebugLog::headerText[16] = { 0 };
-char				IDebugLog::formatBuf[8192] = { 0 };
+thread_local char	IDebugLog::formatBuf[8192] = { 0 };
+thread_local char	IDebugLog::lineBuf[8192 + 0x100] = { 0 };
+thread_local UInt32	IDebugLog::lineLength = 0;
 int					IDebugLog::indentLevel = 0;
 int					IDebugLog::rightMargin = 0;
-int					IDebugLog::cursorPos = 0;
+thread_local int	IDebugLog::cursorPos = 0;
 int					IDebugLog::inBlock = 0;
 bool				IDebugLog::autoFlush = true;
 IDebugLog::LogLevel	IDebugLog::logLevel = IDebugLog::kLevel_DebugMessage;
 IDebugLog::LogLevel	IDebugLog::printLevel = IDebugLog::kLevel_Message;
 
+/**
+ *	Async mode state
+ *	
+ *	Callers claim slots of a bounded MPSC ring (Vyukov-style sequence numbers), so the
+ *	game thread never touches the file. A single consumer, normally the writer thread,
+ *	copies finished lines into a batch buffer and writes it with one fwrite.
+ */
+enum
+{
+	kSlotTextSize =		0xF4,		// slot is 0x100 bytes, longer lines are heap allocated
+	kWriteBatchSize =	0x10000,
+	kWriterIdleWait =	50,			// ms the writer sleeps when it has not been woken
+	kShutdownWait =		1000,
+};
+
+struct LogSlot
+{
+	volatile LONG	sequence;
+	UInt32			length;
+	char			* longText;
+	char			text[kSlotTextSize];
+};
+
+struct AsyncLogState
+{
+	LogSlot			* slots;
+	LONG			mask;
+	volatile LONG	tail;			// next position claimed by a producer
+	volatile LONG	head;			// next position read by the consumer
+	volatile LONG	consumerLock;
+	volatile LONG	writerIdle;
+	volatile LONG	stopWriter;
+	volatile LONG	numDropped;
+	HANDLE			wakeEvent;
+	HANDLE			writerThread;
+	char			* writeBuf;
+	IDebugLog::OverflowPolicy		policy;
+	LPTOP_LEVEL_EXCEPTION_FILTER	prevFilter;
+};
+
+static AsyncLogState	s_async = { 0 };
+static volatile bool	s_asyncEnabled = false;
+
+struct LogRateLimit
+{
+	UInt32			maxPerSecond;
+	volatile DWORD	windowStart;
+	volatile LONG	count;
+	volatile LONG	suppressed;
+};
+
+static LogRateLimit		s_rateLimits[IDebugLog::kLevel_DebugMessage + 1] = { 0 };
+
+static bool LockConsumer(DWORD timeout)
+{
+	DWORD	start = GetTickCount();
+
+	while(InterlockedCompareExchange(&s_async.consumerLock, 1, 0))
+	{
+		if((timeout != INFINITE) && ((GetTickCount() - start) >= timeout))
+			return false;
+		Sleep(0);
+	}
+
+	return true;
+}
+
+static void UnlockConsumer(void)
+{
+	InterlockedExchange(&s_async.consumerLock, 0);
+}
+
+static bool QueueEmpty(void)
+{
+	LONG	pos = s_async.head;
+
+	return s_async.slots[pos & s_async.mask].sequence != (pos + 1);
+}
+
+static void EnqueueLine(const char * buf, UInt32 length)
+{
+	LONG	pos = s_async.tail;
+	LogSlot	* slot;
+
+	while(true)
+	{
+		slot = &s_async.slots[pos & s_async.mask];
+
+		LONG	diff = slot->sequence - pos;
+		if(!diff)
+		{
+			LONG	prev = InterlockedCompareExchange(&s_async.tail, pos + 1, pos);
+			if(prev == pos)
+				break;
+			pos = prev;
+		}
+		else if(diff < 0)
+		{
+			// full; also give up if the writer has been terminated (process exit)
+			if((s_async.policy == IDebugLog::kOverflow_Drop) || s_async.stopWriter ||
+				(WaitForSingleObject(s_async.writerThread, 0) == WAIT_OBJECT_0))
+			{
+				InterlockedIncrement(&s_async.numDropped);
+				return;
+			}
+
+			InterlockedExchange(&s_async.writerIdle, 0);
+			SetEvent(s_async.wakeEvent);
+			SwitchToThread();
+			pos = s_async.tail;
+		}
+		else
+			pos = s_async.tail;
+	}
+
+	slot->longText = NULL;
+	if(length > kSlotTextSize)
+	{
+		slot->longText = (char *)malloc(length);
+		// out of memory, keep what fits
+		if(!slot->longText)
+			length = kSlotTextSize;
+	}
+	slot->length = length;
+	memcpy(slot->longText ? slot->longText : slot->text, buf, length);
+
+	// publish
+	InterlockedExchange(&slot->sequence, pos + 1);
+
+	// a sleeping writer is only woken early once a quarter of the queue is used
+	if(s_async.writerIdle && ((pos - s_async.head) >= (s_async.mask >> 2)) && InterlockedExchange(&s_async.writerIdle, 0))
+		SetEvent(s_async.wakeEvent);
+}
+
 IDebugLog::IDebugLog()
 {
 	//
@@ -27,6 +163,8 @@ IDebugLog::IDebugLog(const char * name)
 
 IDebugLog::~IDebugLog()
 {
+	StopAsync();
+
 	if(logFile)
 		fclose(logFile);
 }
@@ -124,6 +262,9 @@ void IDebugLog::Log(LogLevel level, const char * fmt, va_list args)
 	bool	log = (level <= logLevel);
 	bool	print = (level <= printLevel);
 
+	if((log || print) && !RateLimitAllows(level))
+		return;
+
 	if(log || print)
 		vsprintf_s(formatBuf, sizeof(formatBuf), fmt, args);
 
@@ -132,6 +273,9 @@ void IDebugLog::Log(LogLevel level, const char * fmt, va_list args)
 	
 	if(print)
 		printf("%s\n", formatBuf);
+
+	if(level == kLevel_FatalError)
+		Flush();
 }
 
 /**
@@ -204,52 +348,289 @@ void IDebugLog::SetAutoFlush(bool inAutoFlush)
 	autoFlush = inAutoFlush;
 }
 
+static void FreeAsyncQueue(void)
+{
+	if(s_async.slots)
+		_aligned_free(s_async.slots);
+	if(s_async.writeBuf)
+		free(s_async.writeBuf);
+	if(s_async.wakeEvent)
+		CloseHandle(s_async.wakeEvent);
+	s_async.slots = NULL;
+	s_async.writeBuf = NULL;
+	s_async.wakeEvent = NULL;
+}
+
 /**
- *	Print spaces to the log
+ *	Start writing the log from a background thread
  *	
- *	If possible, tabs are used instead of spaces.
+ *	@param queueSize number of queued lines, rounded up to a power of two
+ *	@param policy what callers do when the queue is full
+ *	@note Anything still queued is written out by Flush, StopAsync, fatal errors and
+ *	unhandled exceptions.
  */
-void IDebugLog::PrintSpaces(int numSpaces)
+void IDebugLog::StartAsync(UInt32 queueSize, OverflowPolicy policy)
 {
-	int	originalNumSpaces = numSpaces;
+	if(s_asyncEnabled || !logFile)
+		return;
 
-	if(logFile)
+	UInt32	numSlots = 0x40;
+	while(numSlots < queueSize)
+		numSlots <<= 1;
+
+	s_async.slots = (LogSlot *)_aligned_malloc(numSlots * sizeof(LogSlot), 0x40);
+	s_async.writeBuf = (char *)malloc(kWriteBatchSize);
+	s_async.wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if(!s_async.slots || !s_async.writeBuf || !s_async.wakeEvent)
+	{
+		FreeAsyncQueue();
+		return;
+	}
+
+	for(UInt32 i = 0; i < numSlots; i++)
+	{
+		s_async.slots[i].sequence = i;
+		s_async.slots[i].longText = NULL;
+	}
+	s_async.mask = numSlots - 1;
+	s_async.tail = 0;
+	s_async.head = 0;
+	s_async.consumerLock = 0;
+	s_async.writerIdle = 0;
+	s_async.stopWriter = 0;
+	s_async.policy = policy;
+
+	// lines queued before this point went straight to the file
+	fflush(logFile);
+
+	s_async.writerThread = CreateThread(NULL, 0, WriterThread, NULL, 0, NULL);
+	if(!s_async.writerThread)
+	{
+		FreeAsyncQueue();
+		return;
+	}
+
+	s_asyncEnabled = true;
+	s_async.prevFilter = SetUnhandledExceptionFilter(CrashFilter);
+}
+
+/**
+ *	Write out everything queued and go back to writing on the calling thread
+ */
+void IDebugLog::StopAsync(void)
+{
+	if(!s_asyncEnabled)
+		return;
+
+	s_asyncEnabled = false;
+	InterlockedExchange(&s_async.stopWriter, 1);
+	SetEvent(s_async.wakeEvent);
+
+	// at process exit the writer has already been terminated, possibly holding the lock
+	WaitForSingleObject(s_async.writerThread, kShutdownWait);
+	bool	locked = LockConsumer(kShutdownWait);
+	DrainQueue();
+	if(locked)
+		UnlockConsumer();
+
+	CloseHandle(s_async.writerThread);
+	s_async.writerThread = NULL;
+}
+
+/**
+ *	Make sure everything logged so far is in the file
+ */
+void IDebugLog::Flush(void)
+{
+	if(s_asyncEnabled)
+	{
+		LockConsumer(INFINITE);
+		DrainQueue();
+		UnlockConsumer();
+	}
+	else if(logFile)
+		fflush(logFile);
+}
+
+/**
+ *	Number of lines discarded because the queue was full (kOverflow_Drop)
+ */
+UInt32 IDebugLog::GetNumDropped(void)
+{
+	return s_async.numDropped;
+}
+
+/**
+ *	Limit the number of messages per second at a log level
+ */
+void IDebugLog::SetRateLimit(LogLevel level, UInt32 maxPerSecond)
+{
+	if(level > kLevel_FatalError && level <= kLevel_DebugMessage)
+	{
+		s_rateLimits[level].maxPerSecond = maxPerSecond;
+		s_rateLimits[level].windowStart = GetTickCount();
+		s_rateLimits[level].count = 0;
+	}
+}
+
+bool IDebugLog::RateLimitAllows(LogLevel level)
+{
+	if(level <= kLevel_FatalError || level > kLevel_DebugMessage)
+		return true;
+
+	LogRateLimit	& limit = s_rateLimits[level];
+	if(!limit.maxPerSecond)
+		return true;
+
+	DWORD	now = GetTickCount();
+	if((now - limit.windowStart) >= 1000)
 	{
-		while(numSpaces > 0)
+		limit.windowStart = now;
+		InterlockedExchange(&limit.count, 0);
+
+		LONG	suppressed = InterlockedExchange(&limit.suppressed, 0);
+		if(suppressed)
 		{
-			if(numSpaces >= TabSize())
-			{
-				numSpaces -= TabSize();
-				fputc('\t', logFile);
-			}
-			else
+			char	note[0x40];
+			sprintf_s(note, sizeof(note), "(%d messages suppressed by rate limit)", suppressed);
+			Message(note);
+		}
+	}
+
+	if((UInt32)InterlockedIncrement(&limit.count) <= limit.maxPerSecond)
+		return true;
+
+	InterlockedIncrement(&limit.suppressed);
+	return false;
+}
+
+/**
+ *	Write out all published lines; the caller must be the only consumer
+ */
+void IDebugLog::DrainQueue(void)
+{
+	LONG	pos = s_async.head, released = pos;
+	UInt32	batchLength = 0;
+
+	while(true)
+	{
+		LogSlot	* slot = &s_async.slots[pos & s_async.mask];
+		bool	ready = (slot->sequence == (pos + 1));
+
+		if(batchLength && (!ready || ((batchLength + slot->length) > kWriteBatchSize)))
+		{
+			if(logFile)
+				fwrite(s_async.writeBuf, 1, batchLength, logFile);
+			batchLength = 0;
+
+			// slots are only handed back once written, so a writer killed mid-batch loses nothing
+			for(; released != pos; released++)
 			{
-				numSpaces--;
-				fputc(' ', logFile);
+				LogSlot	* done = &s_async.slots[released & s_async.mask];
+				if(done->longText)
+				{
+					free(done->longText);
+					done->longText = NULL;
+				}
+				InterlockedExchange(&done->sequence, released + s_async.mask + 1);
 			}
+			s_async.head = pos;
 		}
+
+		if(!ready)
+			break;
+
+		memcpy(s_async.writeBuf + batchLength, slot->longText ? slot->longText : slot->text, slot->length);
+		batchLength += slot->length;
+		pos++;
 	}
 
-	cursorPos += originalNumSpaces;
+	if(logFile)
+		fflush(logFile);
+}
+
+unsigned long __stdcall IDebugLog::WriterThread(void * param)
+{
+	while(!s_async.stopWriter)
+	{
+		LockConsumer(INFINITE);
+		DrainQueue();
+		UnlockConsumer();
+
+		InterlockedExchange(&s_async.writerIdle, 1);
+		if(QueueEmpty() && !s_async.stopWriter)
+			WaitForSingleObject(s_async.wakeEvent, kWriterIdleWait);
+		InterlockedExchange(&s_async.writerIdle, 0);
+	}
+
+	LockConsumer(INFINITE);
+	DrainQueue();
+	UnlockConsumer();
+
+	return 0;
 }
 
 /**
- *	Prints raw text to the log file
+ *	Get queued lines onto disk before the process goes down
  */
-void IDebugLog::PrintText(const char * buf)
+long __stdcall IDebugLog::CrashFilter(struct _EXCEPTION_POINTERS * info)
 {
-	if(logFile)
+	if(s_asyncEnabled)
 	{
-		fputs(buf, logFile);
-		if(autoFlush)
-			fflush(logFile);
+		// the crashing thread may be the writer itself, so don't wait forever
+		bool	locked = LockConsumer(500);
+		DrainQueue();
+		if(locked)
+			UnlockConsumer();
 	}
 
+	return s_async.prevFilter ? s_async.prevFilter(info) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+/**
+ *	Print spaces to the line being composed
+ *	
+ *	If possible, tabs are used instead of spaces.
+ */
+void IDebugLog::PrintSpaces(int numSpaces)
+{
+	int	originalNumSpaces = numSpaces;
+
+	while(numSpaces > 0)
+	{
+		char	data;
+
+		if(numSpaces >= TabSize())
+		{
+			numSpaces -= TabSize();
+			data = '\t';
+		}
+		else
+		{
+			numSpaces--;
+			data = ' ';
+		}
+
+		if(lineLength < (sizeof(lineBuf) - 1))
+			lineBuf[lineLength++] = data;
+	}
+
+	cursorPos += originalNumSpaces;
+}
+
+/**
+ *	Appends raw text to the line being composed
+ */
+void IDebugLog::PrintText(const char * buf)
+{
 	const char	* traverse = buf;
 	char		data;
 
 	while(data = *traverse++)
 	{
+		if(lineLength < (sizeof(lineBuf) - 1))
+			lineBuf[lineLength++] = data;
+
 		if(data == '\t')
 			cursorPos += TabSize();
 		else
@@ -258,19 +639,32 @@ void IDebugLog::PrintText(const char * buf)
 }
 
 /**
- *	Moves to the next line of the log file
+ *	Ends the current line and sends it to the log file
  */
 void IDebugLog::NewLine(void)
 {
-	if(logFile)
+	lineBuf[lineLength++] = '\n';
+
+	WriteLine(lineBuf, lineLength);
+
+	lineLength = 0;
+	cursorPos = 0;
+}
+
+/**
+ *	Writes a finished line directly, or queues it for the writer thread in async mode
+ */
+void IDebugLog::WriteLine(const char * buf, UInt32 length)
+{
+	if(s_asyncEnabled)
+		EnqueueLine(buf, length);
+	else if(logFile)
 	{
-		fputc('\n', logFile);
+		fwrite(buf, 1, length, logFile);
 
 		if(autoFlush)
 			fflush(logFile);
 	}
-
-	cursorPos = 0;
 }
 
 /**
@@ -2,6 +2,8 @@
 
 #include <cstdarg>
 
+struct _EXCEPTION_POINTERS;
+
 /**
  *	A simple debug log file
  *	
@@ -45,6 +47,19 @@ class IDebugLog
 
 		static void			SetAutoFlush(bool inAutoFlush);
 
+		enum OverflowPolicy
+		{
+			kOverflow_Block = 0,	//!< callers wait for the writer when the queue is full
+			kOverflow_Drop			//!< lines that do not fit are discarded and counted
+		};
+
+		static void			StartAsync(UInt32 queueSize = 0x400, OverflowPolicy policy = kOverflow_Block);
+		static void			StopAsync(void);
+		static void			Flush(void);
+		static UInt32		GetNumDropped(void);
+
+		static void			SetRateLimit(LogLevel level, UInt32 maxPerSecond);	//!< 0 = unlimited; fatal errors are never limited
+
 		static void			SetLogLevel(LogLevel in)	{ logLevel = in; }
 		static void			SetPrintLevel(LogLevel in)	{ printLevel = in; }
 
@@ -52,6 +67,12 @@ class IDebugLog
 		static void			PrintSpaces(int numSpaces);
 		static void			PrintText(const char * buf);
 		static void			NewLine(void);
+		static void			WriteLine(const char * buf, UInt32 length);
+		static bool			RateLimitAllows(LogLevel level);
+
+		static void			DrainQueue(void);
+		static unsigned long __stdcall	WriterThread(void * param);
+		static long __stdcall			CrashFilter(struct _EXCEPTION_POINTERS * info);
 
 		static void			SeekCursor(int position);
 
@@ -62,11 +83,13 @@ class IDebugLog
 
 		static char			sourceBuf[16];		//!< name of current source, used in prefix
 		static char			headerText[16];		//!< current text to use as line prefix
-		static char			formatBuf[8192];	//!< temp buffer used for formatted messages
+		static thread_local char	formatBuf[8192];	//!< temp buffer used for formatted messages
+		static thread_local char	lineBuf[8192 + 0x100];	//!< line being composed by the calling thread
+		static thread_local UInt32	lineLength;
 
 		static int			indentLevel;		//!< the current indentation level (in tabs)
 		static int			rightMargin;		//!< the column at which text should be wrapped
-		static int			cursorPos;			//!< current cursor position
+		static thread_local int	cursorPos;		//!< current cursor position
 		static int			inBlock;			//!< are we in a block?
 
 		static bool			autoFlush;			//!< automatically flush the file after writing
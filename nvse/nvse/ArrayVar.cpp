@@ -375,12 +375,15 @@ bool ArrayKey::operator==(const ArrayKey& rhs) const
 
 thread_local ArrayKey s_arrNumKey(kDataType_Numeric), s_arrStrKey(kDataType_String);
 
+UInt32 ArrayVar::s_layoutVersion = 0;
+
 ///////////////////////
 // ArrayVar
 //////////////////////
 
 ArrayVar::ArrayVar(UInt32 _keyType, bool _packed, UInt8 modIndex) : m_ID(0), m_keyType(_keyType), m_bPacked(_packed),
-                                                                    m_owningModIndex(modIndex)
+                                                                    m_owningModIndex(modIndex), m_sharedSourceID(0),
+                                                                    m_layoutVersion(++s_layoutVersion)
 {
 	if (m_keyType == kDataType_String)
 		m_elements.m_type = kContainer_StringMap;
@@ -395,12 +398,19 @@ ArrayElement* ArrayVar::Get(const ArrayKey* key, bool bCanCreateNew)
 	if (m_keyType != key->KeyType())
 		return NULL;
 
+	if (bCanCreateNew)
+	{
+		PrepareWrite();
+		if (m_elements.ShouldConvertToHashed())
+			m_elements.ConvertToHashed();
+	}
+
 	switch (GetContainerType())
 	{
 	default:
 	case kContainer_Array:
 		{
-			auto* pArray = m_elements.getArrayPtr();
+			auto* pArray = Elements().getArrayPtr();
 			int idx = key->key.num;
 			if (idx < 0)
 				idx += pArray->Size();
@@ -414,7 +424,7 @@ ArrayElement* ArrayVar::Get(const ArrayKey* key, bool bCanCreateNew)
 		}
 	case kContainer_NumericMap:
 		{
-			auto* pMap = m_elements.getNumMapPtr();
+			auto* pMap = Elements().getNumMapPtr();
 			if (bCanCreateNew)
 			{
 				ArrayElement* newElem = pMap->Emplace(key->key.num);
@@ -425,7 +435,29 @@ ArrayElement* ArrayVar::Get(const ArrayKey* key, bool bCanCreateNew)
 		}
 	case kContainer_StringMap:
 		{
-			auto* pMap = m_elements.getStrMapPtr();
+			auto* pMap = Elements().getStrMapPtr();
+			if (bCanCreateNew)
+			{
+				ArrayElement* newElem = pMap->Emplace(key->key.str);
+				newElem->m_data.owningArray = m_ID;
+				return newElem;
+			}
+			return pMap->GetPtr(key->key.str);
+		}
+	case kContainer_HashedNumericMap:
+		{
+			auto* pMap = Elements().getHashedNumMapPtr();
+			if (bCanCreateNew)
+			{
+				ArrayElement* newElem = pMap->Emplace(key->key.num);
+				newElem->m_data.owningArray = m_ID;
+				return newElem;
+			}
+			return pMap->GetPtr(key->key.num);
+		}
+	case kContainer_HashedStringMap:
+		{
+			auto* pMap = Elements().getHashedStrMapPtr();
 			if (bCanCreateNew)
 			{
 				ArrayElement* newElem = pMap->Emplace(key->key.str);
@@ -442,12 +474,19 @@ ArrayElement* ArrayVar::Get(double key, bool bCanCreateNew)
 	if (m_keyType != kDataType_Numeric)
 		return NULL;
 
+	if (bCanCreateNew)
+	{
+		PrepareWrite();
+		if (m_elements.ShouldConvertToHashed())
+			m_elements.ConvertToHashed();
+	}
+
 	switch (GetContainerType())
 	{
 	default:
 	case kContainer_Array:
 		{
-			auto* pArray = m_elements.getArrayPtr();
+			auto* pArray = Elements().getArrayPtr();
 			int idx = key;
 			if (idx < 0)
 				idx += pArray->Size();
@@ -461,7 +500,18 @@ ArrayElement* ArrayVar::Get(double key, bool bCanCreateNew)
 		}
 	case kContainer_NumericMap:
 		{
-			auto* pMap = m_elements.getNumMapPtr();
+			auto* pMap = Elements().getNumMapPtr();
+			if (bCanCreateNew)
+			{
+				ArrayElement* newElem = pMap->Emplace(key);
+				newElem->m_data.owningArray = m_ID;
+				return newElem;
+			}
+			return pMap->GetPtr(key);
+		}
+	case kContainer_HashedNumericMap:
+		{
+			auto* pMap = Elements().getHashedNumMapPtr();
 			if (bCanCreateNew)
 			{
 				ArrayElement* newElem = pMap->Emplace(key);
@@ -475,10 +525,31 @@ ArrayElement* ArrayVar::Get(double key, bool bCanCreateNew)
 
 ArrayElement* ArrayVar::Get(const char* key, bool bCanCreateNew)
 {
-	if ((m_keyType != kDataType_String) || (GetContainerType() != kContainer_StringMap))
+	if (m_keyType != kDataType_String)
 		return NULL;
 
-	auto* pMap = m_elements.getStrMapPtr();
+	if (bCanCreateNew)
+	{
+		PrepareWrite();
+		if (m_elements.ShouldConvertToHashed())
+			m_elements.ConvertToHashed();
+	}
+
+	if (GetContainerType() == kContainer_HashedStringMap)
+	{
+		auto* pMap = Elements().getHashedStrMapPtr();
+		if (bCanCreateNew)
+		{
+			ArrayElement* newElem = pMap->Emplace(const_cast<char*>(key));
+			newElem->m_data.owningArray = m_ID;
+			return newElem;
+		}
+		return pMap->GetPtr(const_cast<char*>(key));
+	}
+	if (GetContainerType() != kContainer_StringMap)
+		return NULL;
+
+	auto* pMap = Elements().getStrMapPtr();
 	if (bCanCreateNew)
 	{
 		ArrayElement* newElem = pMap->Emplace(const_cast<char*>(key));
@@ -683,6 +754,77 @@ DataType ArrayVar::GetElementType(const ArrayKey* key)
 	return elem ? elem->DataType() : kDataType_Invalid;
 }
 
+template <class T_Map>
+static const ArrayKey* FindInNumericMap(T_Map* pMap, const ArrayElement* toFind, const Slice* range)
+{
+	typename T_Map::Iterator iter(*pMap);
+	if (range)
+	{
+		if (range->bIsString)
+			return NULL;
+		bool inRange = false;
+		for (; !iter.End(); ++iter)
+		{
+			if (!inRange)
+			{
+				if (iter.Key() >= range->m_lower)
+					inRange = true;
+				else continue;
+			}
+			if (iter.Key() > range->m_upper)
+				return NULL;
+			if (iter.Get() == *toFind) break;
+		}
+	}
+	else
+	{
+		for (; !iter.End(); ++iter)
+			if (iter.Get() == *toFind) break;
+	}
+	if (!iter.End())
+	{
+		s_arrNumKey.key.num = iter.Key();
+		return &s_arrNumKey;
+	}
+	return NULL;
+}
+
+template <class T_Map>
+static const ArrayKey* FindInStringMap(T_Map* pMap, const ArrayElement* toFind, const Slice* range)
+{
+	typename T_Map::Iterator iter(*pMap);
+	if (range)
+	{
+		if (!range->bIsString)
+			return NULL;
+		const char *sLow = range->m_lowerStr.c_str(), *sHigh = range->m_upperStr.c_str();
+		bool inRange = false;
+		for (; !iter.End(); ++iter)
+		{
+			if (!inRange)
+			{
+				if (StrCompare(iter.Key(), sLow) >= 0)
+					inRange = true;
+				else continue;
+			}
+			if (StrCompare(iter.Key(), sHigh) > 0)
+				return NULL;
+			if (iter.Get() == *toFind) break;
+		}
+	}
+	else
+	{
+		for (; !iter.End(); ++iter)
+			if (iter.Get() == *toFind) break;
+	}
+	if (!iter.End())
+	{
+		s_arrStrKey.key.str = const_cast<char*>(iter.Key());
+		return &s_arrStrKey;
+	}
+	return NULL;
+}
+
 const ArrayKey* ArrayVar::Find(const ArrayElement* toFind, const Slice* range)
 {
 	if (Empty()) return NULL;
@@ -692,7 +834,7 @@ const ArrayKey* ArrayVar::Find(const ArrayElement* toFind, const Slice* range)
 	default:
 	case kContainer_Array:
 		{
-			ElementVector* pArray = m_elements.getArrayPtr();
+			ElementVector* pArray = Elements().getArrayPtr();
 			UInt32 arrSize = pArray->Size(), iLow, iHigh;
 			if (range)
 			{
@@ -720,72 +862,13 @@ const ArrayKey* ArrayVar::Find(const ArrayElement* toFind, const Slice* range)
 			return NULL;
 		}
 	case kContainer_NumericMap:
-		{
-			ElementNumMap::Iterator iter(*m_elements.getNumMapPtr());
-			if (range)
-			{
-				if (range->bIsString)
-					return NULL;
-				bool inRange = false;
-				for (; !iter.End(); ++iter)
-				{
-					if (!inRange)
-					{
-						if (iter.Key() >= range->m_lower)
-							inRange = true;
-						else continue;
-					}
-					if (iter.Key() > range->m_upper)
-						return NULL;
-					if (iter.Get() == *toFind) break;
-				}
-			}
-			else
-			{
-				for (; !iter.End(); ++iter)
-					if (iter.Get() == *toFind) break;
-			}
-			if (!iter.End())
-			{
-				s_arrNumKey.key.num = iter.Key();
-				return &s_arrNumKey;
-			}
-			return NULL;
-		}
+		return FindInNumericMap(Elements().getNumMapPtr(), toFind, range);
 	case kContainer_StringMap:
-		{
-			ElementStrMap::Iterator iter(*m_elements.getStrMapPtr());
-			if (range)
-			{
-				if (!range->bIsString)
-					return NULL;
-				const char *sLow = range->m_lowerStr.c_str(), *sHigh = range->m_upperStr.c_str();
-				bool inRange = false;
-				for (; !iter.End(); ++iter)
-				{
-					if (!inRange)
-					{
-						if (StrCompare(iter.Key(), sLow) >= 0)
-							inRange = true;
-						else continue;
-					}
-					if (StrCompare(iter.Key(), sHigh) > 0)
-						return NULL;
-					if (iter.Get() == *toFind) break;
-				}
-			}
-			else
-			{
-				for (; !iter.End(); ++iter)
-					if (iter.Get() == *toFind) break;
-			}
-			if (!iter.End())
-			{
-				s_arrStrKey.key.str = const_cast<char*>(iter.Key());
-				return &s_arrStrKey;
-			}
-			return NULL;
-		}
+		return FindInStringMap(Elements().getStrMapPtr(), toFind, range);
+	case kContainer_HashedNumericMap:
+		return FindInNumericMap(Elements().getHashedNumMapPtr(), toFind, range);
+	case kContainer_HashedStringMap:
+		return FindInStringMap(Elements().getHashedStrMapPtr(), toFind, range);
 	}
 }
 
@@ -793,7 +876,7 @@ bool ArrayVar::GetFirstElement(ArrayElement** outElem, const ArrayKey** outKey)
 {
 	if (Empty()) return false;
 
-	ArrayIterator iter = m_elements.begin();
+	ArrayIterator iter = Elements().begin();
 	*outKey = iter.first();
 	*outElem = iter.second();
 	return true;
@@ -803,7 +886,7 @@ bool ArrayVar::GetLastElement(ArrayElement** outElem, const ArrayKey** outKey)
 {
 	if (Empty()) return false;
 
-	ArrayIterator iter = m_elements.rbegin();
+	ArrayIterator iter = Elements().rbegin();
 	*outKey = iter.first();
 	*outElem = iter.second();
 	return true;
@@ -814,7 +897,7 @@ bool ArrayVar::GetNextElement(const ArrayKey* prevKey, ArrayElement** outElem, c
 	if (!prevKey || Empty())
 		return false;
 
-	ArrayIterator iter = m_elements.find(prevKey);
+	ArrayIterator iter = Elements().find(prevKey);
 	if (!iter.End())
 	{
 		++iter;
@@ -828,12 +911,32 @@ bool ArrayVar::GetNextElement(const ArrayKey* prevKey, ArrayElement** outElem, c
 	return false;
 }
 
+bool ArrayVar::GetFirstElement(ArrayIterator* outIter)
+{
+	if (Empty()) return false;
+
+	*outIter = Elements().begin();
+	return true;
+}
+
+bool ArrayVar::GetNextElement(const ArrayKey* prevKey, ArrayIterator* outIter)
+{
+	if (!prevKey || Empty())
+		return false;
+
+	*outIter = Elements().find(prevKey);
+	if (outIter->End())
+		return false;
+	++(*outIter);
+	return !outIter->End();
+}
+
 bool ArrayVar::GetPrevElement(const ArrayKey* prevKey, ArrayElement** outElem, const ArrayKey** outKey)
 {
 	if (!prevKey || Empty())
 		return false;
 
-	ArrayIterator iter = m_elements.find(prevKey);
+	ArrayIterator iter = Elements().find(prevKey);
 	if (!iter.End())
 	{
 		--iter;
@@ -852,19 +955,27 @@ UInt32 ArrayVar::EraseElement(const ArrayKey* key)
 {
 	if (Empty() || (KeyType() != key->KeyType()))
 		return -1;
+	PrepareWrite();
 	return m_elements.erase(key);
 }
 
 UInt32 ArrayVar::EraseElements(const Slice* slice)
 {
 	if (slice->bIsString || Empty()) return -1;
+	PrepareWrite();
 	return m_elements.erase((int)slice->m_lower, (int)slice->m_upper);
 }
 
 UInt32 ArrayVar::EraseAllElements()
 {
-	UInt32 numErased = m_elements.size();
-	if (numErased) m_elements.clear();
+	UInt32 numErased = Size();
+	if (m_sharedSourceID)
+		DetachShared();		// nothing to clone, this copy's own container is already empty
+	else if (numErased)
+	{
+		PrepareWrite();
+		m_elements.clear();
+	}
 	return numErased;
 }
 
@@ -872,6 +983,7 @@ bool ArrayVar::SetSize(UInt32 newSize, const ArrayElement* padWith)
 {
 	if (!m_bPacked) return false;
 
+	PrepareWrite();
 	UInt32 varSize = m_elements.size();
 	if (varSize < newSize)
 	{
@@ -891,6 +1003,7 @@ bool ArrayVar::SetSize(UInt32 newSize, const ArrayElement* padWith)
 bool ArrayVar::Insert(UInt32 atIndex, const ArrayElement* toInsert)
 {
 	if (!m_bPacked) return false;
+	PrepareWrite();
 	auto* pVec = m_elements.getArrayPtr();
 	UInt32 varSize = pVec->Size();
 	if (atIndex > varSize) return false;
@@ -906,7 +1019,8 @@ bool ArrayVar::Insert(UInt32 atIndex, ArrayID rangeID)
 	if (!m_bPacked || !src || !src->m_bPacked)
 		return false;
 
-	auto *pDest = m_elements.getArrayPtr(), *pSrc = src->m_elements.getArrayPtr();
+	PrepareWrite();
+	auto *pDest = m_elements.getArrayPtr(), *pSrc = src->Elements().getArrayPtr();
 	UInt32 destSize = pDest->Size();
 	if (atIndex > destSize)
 		return false;
@@ -930,7 +1044,7 @@ ArrayVar* ArrayVar::GetKeys(UInt8 modIndex)
 	ArrayVar* keysArr = g_ArrayMap.Create(kDataType_Numeric, true, modIndex);
 	double currKey = 0;
 
-	for (ArrayIterator iter = m_elements.begin(); !iter.End(); ++iter)
+	for (ArrayIterator iter = Elements().begin(); !iter.End(); ++iter)
 	{
 		if (m_keyType == kDataType_Numeric)
 			keysArr->SetElementNumber(currKey, iter.first()->key.num);
@@ -942,11 +1056,15 @@ ArrayVar* ArrayVar::GetKeys(UInt8 modIndex)
 	return keysArr;
 }
 
-ArrayVar* ArrayVar::Copy(UInt8 modIndex, bool bDeepCopy)
+ArrayVarElementContainer& ArrayVar::SharedElements() const
+{
+	return g_ArrayMap.Get(m_sharedSourceID)->m_elements;
+}
+
+void ArrayVar::CopyElements(ArrayVar* source, bool bDeepCopy)
 {
-	ArrayVar* copyArr = g_ArrayMap.Create(m_keyType, m_bPacked, modIndex);
 	const ArrayElement* arrElem;
-	for (ArrayIterator iter = m_elements.begin(); !iter.End(); ++iter)
+	for (ArrayIterator iter = source->m_elements.begin(); !iter.End(); ++iter)
 	{
 		TempObject<ArrayKey> tempKey(*iter.first());
 		// required as iterators pass static objects and this function is recursive
@@ -956,23 +1074,121 @@ ArrayVar* ArrayVar::Copy(UInt8 modIndex, bool bDeepCopy)
 			ArrayVar* innerArr = g_ArrayMap.Get(arrElem->m_data.arrID);
 			if (innerArr)
 			{
-				ArrayVar* innerCopy = innerArr->Copy(modIndex, true);
+				ArrayVar* innerCopy = innerArr->Copy(m_owningModIndex, true);
 				if (tempKey().KeyType() == kDataType_Numeric)
 				{
-					if (copyArr->SetElementArray(tempKey().key.num, innerCopy->ID()))
+					if (SetElementArray(tempKey().key.num, innerCopy->ID()))
 						continue;
 				}
-				else if (copyArr->SetElementArray(tempKey().key.GetStr(), innerCopy->ID()))
+				else if (SetElementArray(tempKey().key.GetStr(), innerCopy->ID()))
 					continue;
 			}
 			DEBUG_PRINT("ArrayVarMap::Copy failed to make deep copy of inner array");
 		}
-		else if (!copyArr->SetElement(&tempKey(), arrElem))
+		else if (!SetElement(&tempKey(), arrElem))
 		DEBUG_PRINT("ArrayVarMap::Copy failed to set element in copied array");
 	}
+}
+
+void ArrayVar::Unshare()
+{
+	m_layoutVersion = ++s_layoutVersion;
+	if (m_sharedSourceID)
+	{
+		ArrayVar* source = g_ArrayMap.Get(m_sharedSourceID);
+		m_sharedSourceID = 0;
+		if (source)
+		{
+			source->m_sharedCopies.Remove(m_ID);
+			CopyElements(source, false);
+		}
+	}
+	// about to modify the source, hand every copy its own elements first
+	while (!m_sharedCopies.Empty())
+	{
+		ArrayVar* copyArr = g_ArrayMap.Get(m_sharedCopies.Top());
+		if (copyArr && (copyArr->m_sharedSourceID == m_ID))
+			copyArr->Unshare();
+		else m_sharedCopies.Pop();
+	}
+}
+
+void ArrayVar::DetachShared()
+{
+	if (m_sharedSourceID)
+	{
+		ArrayVar* source = g_ArrayMap.Get(m_sharedSourceID);
+		if (source)
+			source->m_sharedCopies.Remove(m_ID);
+		m_sharedSourceID = 0;
+	}
+	else if (!m_sharedCopies.Empty())
+		Unshare();
+}
+
+bool ArrayVar::HasArrayElements() const
+{
+	for (ArrayIterator iter = Elements().begin(); !iter.End(); ++iter)
+		if (iter.second()->DataType() == kDataType_Array)
+			return true;
+	return false;
+}
+
+ArrayVar* ArrayVar::Copy(UInt8 modIndex, bool bDeepCopy)
+{
+	// the copy reads this array's elements until either side is modified (see PrepareWrite)
+	ArrayVar* source = m_sharedSourceID ? g_ArrayMap.Get(m_sharedSourceID) : this;
+	ArrayVar* copyArr = g_ArrayMap.Create(m_keyType, m_bPacked, modIndex);
+	if (source->Empty())
+		return copyArr;
+	// nested arrays of a deep copy must be copies too, reads through shared elements would return the originals
+	if (bDeepCopy && source->HasArrayElements())
+		copyArr->CopyElements(source, true);
+	else
+	{
+		copyArr->m_sharedSourceID = source->m_ID;
+		source->m_sharedCopies.Append(copyArr->m_ID);
+	}
 	return copyArr;
 }
 
+template <class T_Map>
+static void SliceNumericMap(T_Map* pMap, const Slice* slice, ArrayVar* newVar)
+{
+	bool inRange = false;
+	for (auto iter = pMap->Begin(); !iter.End(); ++iter)
+	{
+		if (!inRange)
+		{
+			if (iter.Key() >= slice->m_lower)
+				inRange = true;
+			else continue;
+		}
+		if (iter.Key() > slice->m_upper)
+			break;
+		newVar->SetElement(iter.Key(), &iter.Get());
+	}
+}
+
+template <class T_Map>
+static void SliceStringMap(T_Map* pMap, const Slice* slice, ArrayVar* newVar)
+{
+	const char *sLow = slice->m_lowerStr.c_str(), *sHigh = slice->m_upperStr.c_str();
+	bool inRange = false;
+	for (auto iter = pMap->Begin(); !iter.End(); ++iter)
+	{
+		if (!inRange)
+		{
+			if (StrCompare(iter.Key(), sLow) >= 0)
+				inRange = true;
+			else continue;
+		}
+		if (StrCompare(iter.Key(), sHigh) > 0)
+			break;
+		newVar->SetElement(iter.Key(), &iter.Get());
+	}
+}
+
 ArrayVar* ArrayVar::MakeSlice(const Slice* slice, UInt8 modIndex)
 {
 	ArrayVar* newVar = g_ArrayMap.Create(m_keyType, m_bPacked, modIndex);
@@ -985,7 +1201,7 @@ ArrayVar* ArrayVar::MakeSlice(const Slice* slice, UInt8 modIndex)
 	default:
 	case kContainer_Array:
 		{
-			ElementVector* pArray = m_elements.getArrayPtr();
+			ElementVector* pArray = Elements().getArrayPtr();
 			UInt32 arrSize = pArray->Size(), iLow = (int)slice->m_lower, iHigh = (int)slice->m_upper;
 			if (iHigh >= arrSize)
 				iHigh = arrSize - 1;
@@ -1001,40 +1217,17 @@ ArrayVar* ArrayVar::MakeSlice(const Slice* slice, UInt8 modIndex)
 			break;
 		}
 	case kContainer_NumericMap:
-		{
-			bool inRange = false;
-			for (auto iter = m_elements.getNumMapPtr()->Begin(); !iter.End(); ++iter)
-			{
-				if (!inRange)
-				{
-					if (iter.Key() >= slice->m_lower)
-						inRange = true;
-					else continue;
-				}
-				if (iter.Key() > slice->m_upper)
-					break;
-				newVar->SetElement(iter.Key(), &iter.Get());
-			}
-			break;
-		}
+		SliceNumericMap(Elements().getNumMapPtr(), slice, newVar);
+		break;
 	case kContainer_StringMap:
-		{
-			const char *sLow = slice->m_lowerStr.c_str(), *sHigh = slice->m_upperStr.c_str();
-			bool inRange = false;
-			for (auto iter = m_elements.getStrMapPtr()->Begin(); !iter.End(); ++iter)
-			{
-				if (!inRange)
-				{
-					if (StrCompare(iter.Key(), sLow) >= 0)
-						inRange = true;
-					else continue;
-				}
-				if (StrCompare(iter.Key(), sHigh) > 0)
-					break;
-				newVar->SetElement(iter.Key(), &iter.Get());
-			}
-			break;
-		}
+		SliceStringMap(Elements().getStrMapPtr(), slice, newVar);
+		break;
+	case kContainer_HashedNumericMap:
+		SliceNumericMap(Elements().getHashedNumMapPtr(), slice, newVar);
+		break;
+	case kContainer_HashedStringMap:
+		SliceStringMap(Elements().getHashedStrMapPtr(), slice, newVar);
+		break;
 	}
 	return newVar;
 }
@@ -1126,7 +1319,7 @@ void ArrayVar::Sort(ArrayVar* result, SortOrder order, SortType type, Script* co
 
 	if (Empty()) return;
 
-	ArrayIterator iter = m_elements.begin();
+	ArrayIterator iter = Elements().begin();
 	DataType dataType = iter.second()->DataType();
 	if ((dataType == kDataType_Invalid) || (dataType == kDataType_Array)) // nonsensical to sort array of arrays
 		return;
@@ -1135,7 +1328,7 @@ void ArrayVar::Sort(ArrayVar* result, SortOrder order, SortType type, Script* co
 		type = kSortType_Default;
 
 	auto pOutArr = result->m_elements.getArrayPtr();
-	result->m_elements.m_container.numAlloc = m_elements.size();
+	result->m_elements.m_container.numAlloc = Size();
 	TempObject<ArrayElement> tempElem;
 	tempElem().m_data.owningArray = result->m_ID;
 	bool descending = (order == kSort_Descending);
@@ -1191,7 +1384,7 @@ void ArrayVar::Dump()
 	              owningModName);
 	_MESSAGE("** Dumping Array #%d **\nRefs: %d Owner %02X: %s", m_ID, m_refs.Size(), m_owningModIndex, owningModName);
 
-	for (ArrayIterator iter = m_elements.begin(); !iter.End(); ++iter)
+	for (ArrayIterator iter = Elements().begin(); !iter.End(); ++iter)
 	{
 		char numBuf[0x50];
 		std::string elementInfo("[ ");
@@ -1252,12 +1445,12 @@ void ArrayVar::Dump()
 
 std::string ArrayVar::GetStringRepresentation() const
 {
-	switch (this->m_elements.m_type)
+	switch (Elements().m_type)
 	{
 	case kContainer_Array:
 		{
 			std::string result = "[";
-			auto* container = this->m_elements.getArrayPtr();
+			auto* container = Elements().getArrayPtr();
 			for (auto iter = container->Begin(); !iter.End(); ++iter)
 			{
 				result += iter.Get().GetStringRepresentation();
@@ -1270,7 +1463,7 @@ std::string ArrayVar::GetStringRepresentation() const
 	case kContainer_NumericMap:
 		{
 			std::string result = "[";
-			auto* container = this->m_elements.getNumMapPtr();
+			auto* container = Elements().getNumMapPtr();
 			for (auto iter = container->Begin(); !iter.End(); ++iter)
 			{
 				result += std::to_string(iter.Key()) + ": " + iter.Get().GetStringRepresentation();
@@ -1280,10 +1473,36 @@ std::string ArrayVar::GetStringRepresentation() const
 			result += "]";
 			return result;
 		}
+	case kContainer_HashedNumericMap:
+		{
+			std::string result = "[";
+			auto* container = Elements().getHashedNumMapPtr();
+			for (auto iter = container->Begin(); !iter.End(); ++iter)
+			{
+				result += std::to_string(iter.Key()) + ": " + iter.Get().GetStringRepresentation();
+				if (iter.Index() != container->Size() - 1)
+					result += ", ";
+			}
+			result += "]";
+			return result;
+		}
+	case kContainer_HashedStringMap:
+		{
+			std::string result = "[";
+			auto* container = Elements().getHashedStrMapPtr();
+			for (auto iter = container->Begin(); !iter.End(); ++iter)
+			{
+				result += '"' + std::string(iter.Key()) + '"' + ": " + iter.Get().GetStringRepresentation();
+				if (iter.Index() != container->Size() - 1)
+					result += ", ";
+			}
+			result += "]";
+			return result;
+		}
 	case kContainer_StringMap:
 	{
 		std::string result = "[";
-		auto* container = this->m_elements.getStrMapPtr();
+		auto* container = Elements().getStrMapPtr();
 		for (auto iter = container->Begin(); !iter.End(); ++iter)
 		{
 			result += '"' + std::string(iter.Key()) + '"' + ": " + iter.Get().GetStringRepresentation();
@@ -1410,14 +1629,33 @@ void ArrayVarMap::RemoveReference(double* ref, UInt8 referringModIndex)
 
 ArrayElement* ArrayVarMap::GetElement(ArrayID id, const ArrayKey* key)
 {
+	// callers modify the returned element in place
 	ArrayVar* arr = Get(id);
-	return arr ? arr->Get(key, false) : NULL;
+	if (!arr) return NULL;
+	// an existing element is modified in place, the layout only changes if the array has to be unshared
+	if (arr->IsShared())
+		arr->PrepareWrite();
+	return arr->Get(key, false);
 }
 
 void ArrayVarMap::Save(NVSESerializationInterface* intfc)
 {
 	Clean();
 
+	// copies that still share elements don't hold references to nested arrays yet, give them their own
+	Vector<ArrayID> sharedIDs;
+	while (true)
+	{
+		for (auto iter = vars.Begin(); !iter.End(); ++iter)
+			if (iter.Get().m_sharedSourceID)
+				sharedIDs.Append(iter.Key());
+		if (sharedIDs.Empty()) break;
+		for (auto iter = sharedIDs.Begin(); !iter.End(); ++iter)
+			if (ArrayVar* var = Get(*iter))
+				var->Unshare();
+		sharedIDs.Clear();
+	}
+
 	Serialization::OpenRecord('ARVS', kVersion);
 
 	ArrayVar* pVar;
@@ -1449,7 +1687,7 @@ void ArrayVarMap::Save(NVSESerializationInterface* intfc)
 		Serialization::WriteRecord32(numRefs);
 		if (!numRefs) continue;
 
-		for (ArrayIterator elems = pVar->m_elements.begin(); !elems.End(); ++elems)
+		for (ArrayIterator elems = pVar->Elements().begin(); !elems.End(); ++elems)
 		{
 			pKey = elems.first();
 			pElem = elems.second();
@@ -1492,25 +1730,221 @@ void ArrayVarMap::Save(NVSESerializationInterface* intfc)
 	Serialization::OpenRecord('ARVE', kVersion);
 }
 
+#define ARRAY_PARALLEL_LOAD_THRESHOLD 0x4000	// total elements before decoding is spread across threads
+#define ARRAY_LOAD_MAX_WORKERS 7
+
+struct ArrayRecordPayload
+{
+	ArrayID			arrayID;
+	ArrayVar		*var;		// resolved after every record is registered, the map may move vars while inserting
+	const UInt8		*data;
+	UInt32			length;
+	UInt32			numElements;
+	UInt32			version;
+
+	ArrayRecordPayload(ArrayID _arrayID, const UInt8 *_data, UInt32 _length, UInt32 _numElements, UInt32 _version) :
+		arrayID(_arrayID), var(NULL), data(_data), length(_length), numElements(_numElements), version(_version) {}
+};
+
+// reads from a record payload held in the co-save buffer; behaves like Serialization::ReadRecordXX past the end
+struct ArrayRecordReader
+{
+	const UInt8		*dataPtr;
+	const UInt8		*dataEnd;
+
+	ArrayRecordReader(const UInt8 *data, UInt32 length) : dataPtr(data), dataEnd(data + length) {}
+
+	bool Has(UInt32 size) const {return (UInt32)(dataEnd - dataPtr) >= size;}
+
+	UInt8 Read8() {return Has(1) ? *dataPtr++ : 0;}
+	UInt16 Read16()
+	{
+		if (!Has(2)) return 0;
+		UInt16 result = *(UInt16*)dataPtr;
+		dataPtr += 2;
+		return result;
+	}
+	UInt32 Read32()
+	{
+		if (!Has(4)) return 0;
+		UInt32 result = *(UInt32*)dataPtr;
+		dataPtr += 4;
+		return result;
+	}
+	void Read64(void *outData)
+	{
+		if (!Has(8)) return;
+		*(UInt64*)outData = *(UInt64*)dataPtr;
+		dataPtr += 8;
+	}
+	void ReadData(void *outData, UInt32 size)
+	{
+		if (!Has(size)) size = dataEnd - dataPtr;
+		memcpy(outData, dataPtr, size);
+		dataPtr += size;
+	}
+	void Skip(UInt32 size) {dataPtr = Has(size) ? (dataPtr + size) : dataEnd;}
+};
+
+// Only touches this array (and the thread-safe pool allocator), so records can be decoded concurrently.
+// Returns the number of discarded elements.
+UInt32 ArrayVar::DecodeElements(const UInt8* data, UInt32 length, UInt32 numElements, UInt32 version)
+{
+	ArrayRecordReader reader(data, length);
+	UInt32 numDiscarded = 0;
+	ContainerType contType = m_elements.m_type;
+	char keyBuffer[kMaxMessageLength];
+	UInt16 strLength;
+	double numKey;
+
+	ArrayElement *elements, *elem;
+	ElementNumMap* pNumMap;
+	ElementStrMap* pStrMap;
+	ElementHashedNumMap* pHashedNumMap;
+	ElementHashedStrMap* pHashedStrMap;
+	switch (contType)
+	{
+	case kContainer_Array:
+		{
+			auto* pArray = m_elements.getArrayPtr();
+			pArray->Resize(numElements);
+			elements = pArray->Data();
+			break;
+		}
+	case kContainer_NumericMap:
+		pNumMap = m_elements.getNumMapPtr();
+		break;
+	case kContainer_StringMap:
+		pStrMap = m_elements.getStrMapPtr();
+		break;
+	case kContainer_HashedNumericMap:
+		pHashedNumMap = m_elements.getHashedNumMapPtr();
+		break;
+	case kContainer_HashedStringMap:
+		pHashedStrMap = m_elements.getHashedStrMapPtr();
+		break;
+	default:
+		return 0;
+	}
+
+	for (UInt32 i = 0; i < numElements; i++)
+	{
+		if (m_keyType == kDataType_String)
+		{
+			strLength = reader.Read16();
+			if (strLength >= kMaxMessageLength)
+			{
+				reader.ReadData(keyBuffer, kMaxMessageLength - 1);
+				reader.Skip(strLength - (kMaxMessageLength - 1));
+				strLength = kMaxMessageLength - 1;
+			}
+			else if (strLength) reader.ReadData(keyBuffer, strLength);
+			keyBuffer[strLength] = 0;
+		}
+		else if (!m_bPacked || (version < 2))
+			reader.Read64(&numKey);
+
+		UInt8 elemType = reader.Read8();
+
+		switch (contType)
+		{
+		default:
+		case kContainer_Array:
+			elem = &elements[i];
+			break;
+		case kContainer_NumericMap:
+			elem = &(*pNumMap)[numKey];
+			break;
+		case kContainer_StringMap:
+			elem = &(*pStrMap)[keyBuffer];
+			break;
+		case kContainer_HashedNumericMap:
+			elem = &(*pHashedNumMap)[numKey];
+			break;
+		case kContainer_HashedStringMap:
+			elem = &(*pHashedStrMap)[keyBuffer];
+			break;
+		}
+
+		elem->m_data.dataType = (DataType)elemType;
+		elem->m_data.owningArray = m_ID;
+
+		switch (elemType)
+		{
+		case kDataType_Numeric:
+			reader.Read64(&elem->m_data.num);
+			break;
+		case kDataType_String:
+			{
+				strLength = reader.Read16();
+				if (strLength)
+				{
+					char* strVal = (char*)malloc(strLength + 1);
+					reader.ReadData(strVal, strLength);
+					strVal[strLength] = 0;
+					elem->m_data.str = strVal;
+				}
+				else elem->m_data.str = NULL;
+				break;
+			}
+		case kDataType_Array:
+			elem->m_data.arrID = reader.Read32();
+			break;
+		case kDataType_Form:
+			{
+				UInt32 formID = reader.Read32();
+				if (!Serialization::ResolveRefID(formID, &formID))
+					formID = 0;
+				elem->m_data.formID = formID;
+				break;
+			}
+		default:
+			numDiscarded++;
+			break;
+		}
+	}
+	return numDiscarded;
+}
+
+struct ArrayLoadJob
+{
+	Vector<ArrayRecordPayload>	&payloads;
+	volatile LONG				nextIndex;
+	volatile LONG				numDiscarded;
+
+	ArrayLoadJob(Vector<ArrayRecordPayload> &_payloads) : payloads(_payloads), nextIndex(0), numDiscarded(0) {}
+};
+
+static DWORD WINAPI ArrayLoadWorker(LPVOID param)
+{
+	ArrayLoadJob *job = (ArrayLoadJob*)param;
+	UInt32 index, numPayloads = job->payloads.Size();
+	while ((index = InterlockedIncrement(&job->nextIndex) - 1) < numPayloads)
+	{
+		ArrayRecordPayload &payload = job->payloads[index];
+		if (!payload.var) continue;
+		if (UInt32 numDiscarded = payload.var->DecodeElements(payload.data, payload.length, payload.numElements, payload.version))
+			InterlockedExchangeAdd(&job->numDiscarded, numDiscarded);
+	}
+	return 0;
+}
+
 void ArrayVarMap::Load(NVSESerializationInterface* intfc)
 {
 	_MESSAGE("Loading array variables");
 
 	Clean(); // clean up any vars queued for garbage collection
 
-	UInt32 type, length, version, arrayID, tempRefID, numElements;
-	UInt16 strLength;
+	UInt32 type, length, version, arrayID, tempRefID, numElements, totalElements = 0;
 	UInt8 modIndex, keyType;
 	bool bPacked;
-	ContainerType contType;
 	static UInt8 buffer[kMaxMessageLength];
+	Vector<ArrayRecordPayload> payloads;
 
 	//Reset(intfc);
 	bool bContinue = true;
 	UInt32 lastIndexRead = 0;
 
-	double numKey;
-
 	while (bContinue && Serialization::GetNextRecordInfo(&type, &version, &length))
 	{
 		switch (type)
@@ -1596,99 +2030,17 @@ void ArrayVarMap::Load(NVSESerializationInterface* intfc)
 				// create array and add to map
 				ArrayVar* newArr = Add(arrayID, keyType, bPacked, modIndex, numRefs, buffer);
 
-				// read the array elements			
+				// read the array elements
 				numElements = Serialization::ReadRecord32();
 				if (!numElements) continue;
 
-				contType = newArr->GetContainerType();
-
-				ArrayElement *elements, *elem;
-				ElementNumMap* pNumMap;
-				ElementStrMap* pStrMap;
-				switch (contType)
-				{
-				case kContainer_Array:
-					{
-						auto* pArray = newArr->m_elements.getArrayPtr();
-						pArray->Resize(numElements);
-						elements = pArray->Data();
-						break;
-					}
-				case kContainer_NumericMap:
-					pNumMap = newArr->m_elements.getNumMapPtr();
-					break;
-				case kContainer_StringMap:
-					pStrMap = newArr->m_elements.getStrMapPtr();
-					break;
-				default:
-					continue;
-				}
-
-				for (UInt32 i = 0; i < numElements; i++)
-				{
-					if (keyType == kDataType_String)
-					{
-						strLength = Serialization::ReadRecord16();
-						if (strLength) Serialization::ReadRecordData(buffer, strLength);
-						buffer[strLength] = 0;
-					}
-					else if (!bPacked || (version < 2))
-						Serialization::ReadRecord64(&numKey);
-
-					UInt8 elemType = Serialization::ReadRecord8();
+				if (numElements >= ARRAY_HASHED_MAP_THRESHOLD)
+					newArr->UseHashedStorage();
 
-					switch (contType)
-					{
-					default:
-					case kContainer_Array:
-						elem = &elements[i];
-						break;
-					case kContainer_NumericMap:
-						elem = &(*pNumMap)[numKey];
-						break;
-					case kContainer_StringMap:
-						elem = &(*pStrMap)[(char*)buffer];
-						break;
-					}
-
-					elem->m_data.dataType = (DataType)elemType;
-					elem->m_data.owningArray = arrayID;
-
-					switch (elemType)
-					{
-					case kDataType_Numeric:
-						Serialization::ReadRecord64(&elem->m_data.num);
-						break;
-					case kDataType_String:
-						{
-							strLength = Serialization::ReadRecord16();
-							if (strLength)
-							{
-								char* strVal = (char*)malloc(strLength + 1);
-								Serialization::ReadRecordData(strVal, strLength);
-								strVal[strLength] = 0;
-								elem->m_data.str = strVal;
-							}
-							else elem->m_data.str = NULL;
-							break;
-						}
-					case kDataType_Array:
-						elem->m_data.arrID = Serialization::ReadRecord32();
-						break;
-					case kDataType_Form:
-						{
-							UInt32 formID = Serialization::ReadRecord32();
-							if (!Serialization::ResolveRefID(formID, &formID))
-								formID = 0;
-							elem->m_data.formID = formID;
-							break;
-						}
-					default:
-						_MESSAGE("Unknown element type %d encountered while loading array var, element discarded.",
-						         elemType);
-						break;
-					}
-				}
+				// element payloads are decoded once every record has been registered
+				const UInt8* payloadData = Serialization::ReadRecordSpan(&length);
+				payloads.Append(arrayID, payloadData, length, numElements, version);
+				totalElements += numElements;
 				break;
 			}
 		default:
@@ -1696,6 +2048,41 @@ void ArrayVarMap::Load(NVSESerializationInterface* intfc)
 			break;
 		}
 	}
+
+	if (payloads.Empty()) return;
+
+	for (auto iter = payloads.Begin(); !iter.End(); ++iter)
+		iter().var = vars.GetPtr(iter().arrayID);
+
+	ArrayLoadJob job(payloads);
+	if ((totalElements >= ARRAY_PARALLEL_LOAD_THRESHOLD) && (payloads.Size() > 1))
+	{
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		UInt32 numThreads = sysInfo.dwNumberOfProcessors - 1;
+		if (numThreads > ARRAY_LOAD_MAX_WORKERS)
+			numThreads = ARRAY_LOAD_MAX_WORKERS;
+		if (numThreads >= payloads.Size())
+			numThreads = payloads.Size() - 1;
+
+		HANDLE workers[ARRAY_LOAD_MAX_WORKERS];
+		UInt32 numWorkers = 0;
+		for (; numWorkers < numThreads; numWorkers++)
+			if (!(workers[numWorkers] = CreateThread(NULL, 0, ArrayLoadWorker, &job, 0, NULL)))
+				break;
+
+		ArrayLoadWorker(&job);
+		if (numWorkers)
+		{
+			WaitForMultipleObjects(numWorkers, workers, TRUE, INFINITE);
+			for (UInt32 i = 0; i < numWorkers; i++)
+				CloseHandle(workers[i]);
+		}
+	}
+	else ArrayLoadWorker(&job);
+
+	if (job.numDiscarded)
+		_MESSAGE("Unknown element types encountered while loading array vars, %d elements discarded.", job.numDiscarded);
 }
 
 void ArrayVarMap::Clean() // garbage collection: delete unreferenced arrays
@@ -1703,8 +2090,7 @@ void ArrayVarMap::Clean() // garbage collection: delete unreferenced arrays
 	// ArrayVar destructor may queue more IDs for deletion if deleted array contains other arrays
 	// so on each pass through the loop we delete the first ID in the queue until none remain
 
-	while (!tempIDs.Empty())
-		Delete(tempIDs.LastKey());
+	CleanTemporaries();
 }
 
 void ArrayVarMap::DumpAll()
@@ -1781,7 +2167,7 @@ namespace PluginAPI
 	{
 		ArrayVar* arrVar = g_ArrayMap.Get((ArrayID)arr);
 		if (arrVar && (arrVar->KeyType() == kDataType_Numeric) && arrVar->IsPacked())
-			arrVar->SetElementFromAPI((int)arrVar->m_elements.getArrayPtr()->Size(), &value);
+			arrVar->SetElementFromAPI((int)arrVar->Elements().getArrayPtr()->Size(), &value);
 	}
 
 	UInt32 ArrayAPI::GetArraySize(NVSEArrayVarInterface::Array* arr)
@@ -1839,7 +2225,7 @@ namespace PluginAPI
 		{
 			UInt8 keyType = var->KeyType();
 			UInt32 i = 0;
-			for (ArrayIterator iter = var->m_elements.begin(); !iter.End(); ++iter)
+			for (ArrayIterator iter = var->Elements().begin(); !iter.End(); ++iter)
 			{
 				if (keys)
 				{
@@ -150,12 +150,19 @@ enum ContainerType
 {
 	kContainer_Array,
 	kContainer_NumericMap,
-	kContainer_StringMap
+	kContainer_StringMap,
+	kContainer_HashedNumericMap,
+	kContainer_HashedStringMap
 };
 
+// maps switch to hashed storage once they reach this size (or on request, see ar_Construct)
+#define ARRAY_HASHED_MAP_THRESHOLD	0x80
+
 typedef Vector<ArrayElement> ElementVector;
 typedef Map<double, ArrayElement> ElementNumMap;
 typedef Map<char*, ArrayElement> ElementStrMap;
+typedef HashedMap<double, ArrayElement> ElementHashedNumMap;
+typedef HashedMap<char*, ArrayElement> ElementHashedStrMap;
 
 class ArrayVarElementContainer
 {
@@ -166,6 +173,7 @@ class ArrayVarElementContainer
 		void *data;
 		UInt32		 numItems;
 		UInt32		 numAlloc;
+		UInt32		 hashedData[3];	// HashedMap slot table
 	};
 
 	ContainerType		m_type;
@@ -174,6 +182,8 @@ class ArrayVarElementContainer
 	ElementVector& AsArray() const {return *(ElementVector*)&m_container;}
 	ElementNumMap& AsNumMap() const {return *(ElementNumMap*)&m_container;}
 	ElementStrMap& AsStrMap() const {return *(ElementStrMap*)&m_container;}
+	ElementHashedNumMap& AsHashedNumMap() const {return *(ElementHashedNumMap*)&m_container;}
+	ElementHashedStrMap& AsHashedStrMap() const {return *(ElementHashedStrMap*)&m_container;}
 
 public:
 	ArrayVarElementContainer() : m_type(kContainer_Array)
@@ -195,6 +205,13 @@ public:
 
 	UInt32 erase(UInt32 iLow, UInt32 iHigh);
 
+	bool IsHashed() const {return m_type >= kContainer_HashedNumericMap;}
+	bool ShouldConvertToHashed() const
+	{
+		return (m_type == kContainer_NumericMap || m_type == kContainer_StringMap) && (m_container.numItems >= ARRAY_HASHED_MAP_THRESHOLD);
+	}
+	void ConvertToHashed();
+
 	class iterator
 	{
 		friend ArrayVarElementContainer;
@@ -212,8 +229,11 @@ public:
 		ElementVector::Iterator& AsArray() {return *(ElementVector::Iterator*)&m_iter;}
 		ElementNumMap::Iterator& AsNumMap() {return *(ElementNumMap::Iterator*)&m_iter;}
 		ElementStrMap::Iterator& AsStrMap() {return *(ElementStrMap::Iterator*)&m_iter;}
+		ElementHashedNumMap::Iterator& AsHashedNumMap() {return *(ElementHashedNumMap::Iterator*)&m_iter;}
+		ElementHashedStrMap::Iterator& AsHashedStrMap() {return *(ElementHashedStrMap::Iterator*)&m_iter;}
 
 	public:
+		iterator() : m_type(kContainer_Array) {m_iter.contObj = NULL; m_iter.pData = NULL; m_iter.index = 0;}
 		iterator(ArrayVarElementContainer& container);
 		iterator(ArrayVarElementContainer& container, bool reverse);
 		iterator(ArrayVarElementContainer& container, const ArrayKey* key);
@@ -236,6 +256,8 @@ public:
 	ElementVector* getArrayPtr() const {return &AsArray();}
 	ElementNumMap* getNumMapPtr() const {return &AsNumMap();}
 	ElementStrMap* getStrMapPtr() const {return &AsStrMap();}
+	ElementHashedNumMap* getHashedNumMapPtr() const {return &AsHashedNumMap();}
+	ElementHashedStrMap* getHashedStrMapPtr() const {return &AsHashedStrMap();}
 };
 
 typedef ArrayVarElementContainer::iterator ArrayIterator;
@@ -254,6 +276,17 @@ class ArrayVar
 	UInt8				m_keyType;
 	bool				m_bPacked;
 	Vector<UInt8>		m_refs;		// data is modIndex of referring object; size() is number of references
+	ArrayID				m_sharedSourceID;	// copy-on-write: nonzero while elements are read from this array
+	Vector<ArrayID>		m_sharedCopies;		// copies currently reading this array's elements
+	UInt32				m_layoutVersion;	// changes whenever elements may be added, removed or moved
+
+	static UInt32		s_layoutVersion;
+
+	_ElementMap& SharedElements() const;
+	_ElementMap& Elements() const {return m_sharedSourceID ? SharedElements() : const_cast<_ElementMap&>(m_elements);}
+	void CopyElements(ArrayVar* source, bool bDeepCopy);
+	bool HasArrayElements() const;
+	void Unshare();
 
 public:
 	ArrayVar(UInt32 keyType, bool packed, UInt8 modIndex);
@@ -275,9 +308,21 @@ public:
 	UInt8 KeyType() const {return m_keyType;}
 	bool IsPacked() const {return m_bPacked;}
 	UInt8 OwningModIndex() const {return m_owningModIndex;}
-	UInt32 Size() const {return m_elements.size();}
-	bool Empty() const {return m_elements.empty();}
-	ContainerType GetContainerType() const {return m_elements.m_type;}
+	UInt32 Size() const {return Elements().size();}
+	bool Empty() const {return Elements().empty();}
+	ContainerType GetContainerType() const {return Elements().m_type;}
+	void UseHashedStorage() {if (!m_bPacked) {PrepareWrite(); m_elements.ConvertToHashed();}}
+
+	// Must precede any modification of m_elements
+	void PrepareWrite() {m_layoutVersion = ++s_layoutVersion; if (m_sharedSourceID || !m_sharedCopies.Empty()) Unshare();}
+	// Iterators and element pointers obtained while this is unchanged are still valid
+	UInt32 LayoutVersion() const {return m_layoutVersion;}
+	bool IsShared() const {return m_sharedSourceID || !m_sharedCopies.Empty();}
+	bool ReadsSharedElements() const {return m_sharedSourceID != 0;}
+	// Drops copy-on-write links without cloning; used when the array is being deleted
+	void DetachShared();
+	// Fills a freshly loaded array from its ARVR element payload
+	UInt32 DecodeElements(const UInt8* data, UInt32 length, UInt32 numElements, UInt32 version);
 
 	ArrayElement* Get(const ArrayKey* key, bool bCanCreateNew);
 	ArrayElement* Get(double key, bool bCanCreateNew);
@@ -319,6 +364,9 @@ public:
 	bool GetLastElement(ArrayElement** outElem, const ArrayKey** outKey);
 	bool GetNextElement(const ArrayKey* prevKey, ArrayElement** outElem, const ArrayKey** outKey);
 	bool GetPrevElement(const ArrayKey* prevKey, ArrayElement** outElem, const ArrayKey** outKey);
+	// Same as GetFirstElement/GetNextElement but leave an iterator that ++ can continue from
+	bool GetFirstElement(ArrayIterator* outIter);
+	bool GetNextElement(const ArrayKey* prevKey, ArrayIterator* outIter);
 
 	UInt32 EraseElement(const ArrayKey* key);
 	UInt32 EraseElements(const Slice* slice);	// returns num erased
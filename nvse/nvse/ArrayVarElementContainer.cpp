@@ -16,6 +16,12 @@ ArrayVarElementContainer::~ArrayVarElementContainer()
 		case kContainer_StringMap:
 			AsStrMap().~ElementStrMap();
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().~ElementHashedNumMap();
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().~ElementHashedStrMap();
+			break;
 	}
 }
 
@@ -46,6 +52,57 @@ void ArrayVarElementContainer::clear()
 			AsStrMap().Clear();
 			break;
 		}
+		case kContainer_HashedNumericMap:
+		{
+			for (auto iter = AsHashedNumMap().Begin(); !iter.End(); ++iter)
+				iter.Get().Unset();
+			AsHashedNumMap().Clear();
+			break;
+		}
+		case kContainer_HashedStringMap:
+		{
+			for (auto iter = AsHashedStrMap().Begin(); !iter.End(); ++iter)
+				iter.Get().Unset();
+			AsHashedStrMap().Clear();
+			break;
+		}
+	}
+}
+
+void ArrayVarElementContainer::ConvertToHashed()
+{
+	// elements are moved bitwise; the source entries are invalidated so its destructor leaves them alone
+	GenericContainer source = m_container;
+	switch (m_type)
+	{
+		case kContainer_NumericMap:
+		{
+			ElementNumMap &numMap = *(ElementNumMap*)&source;
+			new (&m_container) ElementHashedNumMap(source.numAlloc);
+			for (auto iter = numMap.Begin(); !iter.End(); ++iter)
+			{
+				memcpy(AsHashedNumMap().Emplace(iter.Key()), &iter.Get(), sizeof(ArrayElement));
+				iter.Get().m_data.dataType = kDataType_Invalid;
+			}
+			numMap.~ElementNumMap();
+			m_type = kContainer_HashedNumericMap;
+			break;
+		}
+		case kContainer_StringMap:
+		{
+			ElementStrMap &strMap = *(ElementStrMap*)&source;
+			new (&m_container) ElementHashedStrMap(source.numAlloc);
+			for (auto iter = strMap.Begin(); !iter.End(); ++iter)
+			{
+				memcpy(AsHashedStrMap().Emplace(iter.Key()), &iter.Get(), sizeof(ArrayElement));
+				iter.Get().m_data.dataType = kDataType_Invalid;
+			}
+			strMap.~ElementStrMap();
+			m_type = kContainer_HashedStringMap;
+			break;
+		}
+		default:
+			break;
 	}
 }
 
@@ -88,12 +145,34 @@ UInt32 ArrayVarElementContainer::erase(const ArrayKey *key)
 			findKey.Remove(false);
 			return 1;
 		}
+		case kContainer_HashedNumericMap:
+		{
+			if (key->key.dataType != kDataType_Numeric)
+				return 0;
+			ArrayElement *element = AsHashedNumMap().GetPtr(key->key.num);
+			if (!element)
+				return 0;
+			element->Unset();
+			AsHashedNumMap().Erase(key->key.num);
+			return 1;
+		}
+		case kContainer_HashedStringMap:
+		{
+			if (key->key.dataType != kDataType_String)
+				return 0;
+			ArrayElement *element = AsHashedStrMap().GetPtr(key->key.str);
+			if (!element)
+				return 0;
+			element->Unset();
+			AsHashedStrMap().Erase(key->key.str);
+			return 1;
+		}
 	}
 }
 
 UInt32 ArrayVarElementContainer::erase(UInt32 iLow, UInt32 iHigh)
 {
-	if (empty() || (m_type != kContainer_Array && m_type != kContainer_NumericMap))
+	if (empty() || (m_type != kContainer_Array && m_type != kContainer_NumericMap && m_type != kContainer_HashedNumericMap))
 		return 0;
 	UInt32 arrSize = m_container.numItems;
 	if (iHigh >= arrSize)
@@ -126,6 +205,22 @@ UInt32 ArrayVarElementContainer::erase(UInt32 iLow, UInt32 iHigh)
 		}
 		return numErased;
 	}
+	if (m_type == kContainer_HashedNumericMap)
+	{
+		auto& elements = AsHashedNumMap();
+		auto numErased = 0U;
+		for (auto i = iLow; i < iHigh; ++i)
+		{
+			auto* element = elements.GetPtr(i);
+			if (element)
+			{
+				element->Unset();
+				elements.Erase(i);
+				++numErased;
+			}
+		}
+		return numErased;
+	}
 	return -1;
 }
 
@@ -144,6 +239,12 @@ ArrayVarElementContainer::iterator::iterator(ArrayVarElementContainer& container
 		case kContainer_StringMap:
 			AsStrMap().Init(container.AsStrMap());
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().Init(container.AsHashedNumMap());
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().Init(container.AsHashedStrMap());
+			break;
 	}
 }
 
@@ -162,6 +263,12 @@ ArrayVarElementContainer::iterator::iterator(ArrayVarElementContainer& container
 		case kContainer_StringMap:
 			AsStrMap().Last(container.AsStrMap());
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().Last(container.AsHashedNumMap());
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().Last(container.AsHashedStrMap());
+			break;
 	}
 }
 
@@ -180,6 +287,12 @@ ArrayVarElementContainer::iterator::iterator(ArrayVarElementContainer& container
 		case kContainer_StringMap:
 			AsStrMap().Find(container.AsStrMap(), key->key.str);
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().Find(container.AsHashedNumMap(), key->key.num);
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().Find(container.AsHashedStrMap(), key->key.str);
+			break;
 	}
 }
 
@@ -196,6 +309,12 @@ void ArrayVarElementContainer::iterator::operator++()
 		case kContainer_StringMap:
 			AsStrMap().operator++();
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().operator++();
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().operator++();
+			break;
 	}
 }
 
@@ -212,6 +331,12 @@ void ArrayVarElementContainer::iterator::operator--()
 		case kContainer_StringMap:
 			AsStrMap().operator--();
 			break;
+		case kContainer_HashedNumericMap:
+			AsHashedNumMap().operator--();
+			break;
+		case kContainer_HashedStringMap:
+			AsHashedStrMap().operator--();
+			break;
 	}
 }
 
@@ -229,6 +354,12 @@ const ArrayKey* ArrayVarElementContainer::iterator::first()
 		case kContainer_StringMap:
 			s_arrStrKey.key.str = const_cast<char*>(AsStrMap().Key());
 			return &s_arrStrKey;
+		case kContainer_HashedNumericMap:
+			s_arrNumKey.key.num = AsHashedNumMap().Key();
+			return &s_arrNumKey;
+		case kContainer_HashedStringMap:
+			s_arrStrKey.key.str = AsHashedStrMap().Key();
+			return &s_arrStrKey;
 	}
 }
 
@@ -243,6 +374,10 @@ ArrayElement* ArrayVarElementContainer::iterator::second()
 			return &AsNumMap().Get();
 		case kContainer_StringMap:
 			return &AsStrMap().Get();
+		case kContainer_HashedNumericMap:
+			return &AsHashedNumMap().Get();
+		case kContainer_HashedStringMap:
+			return &AsHashedStrMap().Get();
 	}
 }
 
@@ -0,0 +1,178 @@
+#include "BlockCompression.h"
+
+namespace BlockCompression
+{
+
+#define HASH_LOG		12
+#define MIN_MATCH		4
+#define LAST_LITERALS	5	// format requires the final bytes of a block to be literals
+#define MATCH_LIMIT		12	// last match must start at least this far from the end
+
+// unaligned accesses through memcpy, which compiles to single moves
+static __forceinline UInt32 Load32(const UInt8 *p)
+{
+	UInt32 value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static __forceinline UInt16 Load16(const UInt8 *p)
+{
+	UInt16 value;
+	memcpy(&value, p, 2);
+	return value;
+}
+
+static __forceinline void Store16(UInt8 *p, UInt16 value)
+{
+	memcpy(p, &value, 2);
+}
+
+static __forceinline UInt32 Hash4(UInt32 sequence)
+{
+	return (sequence * 0x9E3779B1) >> (32 - HASH_LOG);
+}
+
+static __forceinline UInt8 *WriteLength(UInt8 *op, UInt32 length)
+{
+	for (; length >= 0xFF; length -= 0xFF)
+		*op++ = 0xFF;
+	*op++ = (UInt8)length;
+	return op;
+}
+
+static __forceinline const UInt8 *ReadLength(const UInt8 *ip, const UInt8 *srcEnd, UInt32 *length)
+{
+	UInt8 byte;
+	do
+	{
+		if (ip >= srcEnd) return NULL;
+		byte = *ip++;
+		*length += byte;
+	}
+	while (byte == 0xFF);
+	return ip;
+}
+
+UInt32 Pack(const UInt8 *src, UInt32 srcSize, UInt8 *dest, UInt32 destSize)
+{
+	if (srcSize <= MATCH_LIMIT) return 0;
+
+	UInt32 hashTable[1 << HASH_LOG] = {0};
+	const UInt8 *ip = src, *anchor = src, *srcEnd = src + srcSize;
+	const UInt8 *matchLimit = srcEnd - MATCH_LIMIT, *lastLiterals = srcEnd - LAST_LITERALS;
+	UInt8 *op = dest, *destEnd = dest + destSize;
+	UInt32 sequence, hashVal, litLength, matchLength;
+	const UInt8 *ref, *matchEnd;
+
+	while (ip < matchLimit)
+	{
+		sequence = Load32(ip);
+		hashVal = Hash4(sequence);
+		ref = src + hashTable[hashVal];
+		hashTable[hashVal] = ip - src;
+		if ((ref >= ip) || ((ip - ref) > 0xFFFF) || (Load32(ref) != sequence))
+		{
+			ip++;
+			continue;
+		}
+		while ((ip > anchor) && (ref > src) && (ip[-1] == ref[-1]))
+		{
+			ip--;
+			ref--;
+		}
+		matchEnd = ip + MIN_MATCH;
+		for (const UInt8 *pRef = ref + MIN_MATCH; (matchEnd < lastLiterals) && (*matchEnd == *pRef); matchEnd++, pRef++);
+
+		litLength = ip - anchor;
+		matchLength = matchEnd - ip - MIN_MATCH;
+		if ((op + litLength + (litLength / 0xFF) + (matchLength / 0xFF) + 5) > destEnd)
+			return 0;
+
+		UInt8 *token = op++;
+		if (litLength >= 0xF)
+		{
+			*token = 0xF0;
+			op = WriteLength(op, litLength - 0xF);
+		}
+		else *token = litLength << 4;
+		memcpy(op, anchor, litLength);
+		op += litLength;
+
+		Store16(op, ip - ref);
+		op += 2;
+
+		if (matchLength >= 0xF)
+		{
+			*token |= 0xF;
+			op = WriteLength(op, matchLength - 0xF);
+		}
+		else *token |= matchLength;
+
+		ip = anchor = matchEnd;
+	}
+
+	litLength = srcEnd - anchor;
+	if ((op + litLength + (litLength / 0xFF) + 2) > destEnd)
+		return 0;
+	if (litLength >= 0xF)
+	{
+		*op++ = 0xF0;
+		op = WriteLength(op, litLength - 0xF);
+	}
+	else *op++ = litLength << 4;
+	memcpy(op, anchor, litLength);
+	op += litLength;
+
+	UInt32 packedSize = op - dest;
+	return (packedSize < srcSize) ? packedSize : 0;
+}
+
+SInt32 Unpack(const UInt8 *src, UInt32 srcSize, UInt8 *dest, UInt32 destSize)
+{
+	const UInt8 *ip = src, *srcEnd = src + srcSize, *ref;
+	UInt8 *op = dest, *destEnd = dest + destSize;
+	UInt32 token, length, offset;
+
+	while (ip < srcEnd)
+	{
+		token = *ip++;
+		length = token >> 4;
+		if ((length == 0xF) && !(ip = ReadLength(ip, srcEnd, &length)))
+			return -1;
+		if ((length > (UInt32)(srcEnd - ip)) || (length > (UInt32)(destEnd - op)))
+			return -1;
+		memcpy(op, ip, length);
+		op += length;
+		ip += length;
+
+		// final sequence has no match part
+		if (ip >= srcEnd) break;
+
+		if ((srcEnd - ip) < 2) return -1;
+		offset = Load16(ip);
+		ip += 2;
+		if (!offset || (offset > (UInt32)(op - dest)))
+			return -1;
+
+		length = token & 0xF;
+		if ((length == 0xF) && !(ip = ReadLength(ip, srcEnd, &length)))
+			return -1;
+		length += MIN_MATCH;
+		if (length > (UInt32)(destEnd - op))
+			return -1;
+
+		ref = op - offset;
+		if (offset >= length)
+		{
+			memcpy(op, ref, length);
+			op += length;
+		}
+		else while (length--)	// overlapping match repeats the preceding bytes
+			*op++ = *ref++;
+	}
+
+	return op - dest;
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// LZ4-compatible block codec used for co-save data. No OS dependencies.
+
+namespace BlockCompression
+{
+	enum
+	{
+		kBlockSize =	0x10000,
+	};
+
+	// worst case output size for a block of inSize bytes
+	inline UInt32 GetMaxPackedSize(UInt32 inSize) {return inSize + (inSize / 0xFF) + 0x10;}
+
+	// returns packed size, or 0 if the output would not be smaller than the input
+	UInt32 Pack(const UInt8 *src, UInt32 srcSize, UInt8 *dest, UInt32 destSize);
+
+	// returns the number of bytes written to dest, or -1 on malformed input
+	SInt32 Unpack(const UInt8 *src, UInt32 srcSize, UInt8 *dest, UInt32 destSize);
+}
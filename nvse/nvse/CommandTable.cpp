@@ -342,7 +342,7 @@ DEFINE_COMMAND(DumpDocs, , 0, 0, NULL);
 #define ADD_CMD_RET(command, rtnType) Add(&kCommandInfo_ ## command, rtnType )
 #define REPL_CMD(command) Replace(GetByName(command)->opcode, &kCommandInfo_ ## command )
 
-CommandTable::CommandTable() { }
+CommandTable::CommandTable() : m_nameIndex(0x1000), m_nameIndexValid(false) { }
 CommandTable::~CommandTable() { }
 
 void CommandTable::Init(void)
@@ -418,14 +418,19 @@ void CommandTable::Add(CommandInfo * info, CommandReturnType retnType, UInt32 pa
 	if(m_curID == backCommandID)
 	{
 		// adding at the end?
+		ScopedLock lock(m_nameIndexLock);
 		m_commands.push_back(*info);
+		if (m_nameIndexValid)
+			IndexCommandNames(m_commands.size() - 1);
 	}
 	else if(m_curID < backCommandID)
 	{
 		// adding to existing data?
 		ASSERT(m_curID >= m_baseID);
 
+		ScopedLock lock(m_nameIndexLock);
 		m_commands[m_curID - m_baseID] = *info;
+		m_nameIndexValid = false;
 	}
 	else
 	{
@@ -446,8 +451,10 @@ bool CommandTable::Replace(UInt32 opcodeToReplace, CommandInfo* replaceWith)
 	{
 		if (iter->opcode == opcodeToReplace)
 		{
+			ScopedLock lock(m_nameIndexLock);
 			*iter = *replaceWith;
 			iter->opcode = opcodeToReplace;
+			m_nameIndexValid = false;
 			return true;
 		}
 	}
@@ -474,10 +481,13 @@ void CommandTable::PadTo(UInt32 id, CommandInfo * info)
 {
 	if(!info) info = &kPaddingCommand;
 
+	ScopedLock lock(m_nameIndexLock);
 	while(m_baseID + m_commands.size() < id)
 	{
 		info->opcode = m_baseID + m_commands.size();
 		m_commands.push_back(*info);
+		if (m_nameIndexValid)
+			IndexCommandNames(m_commands.size() - 1);
 	}
 
 	m_curID = id;
@@ -718,13 +728,53 @@ void CommandInfo::DumpFunctionDef() const
 }
 
 
+// only adds names not already taken, so lookups keep returning the first command in table order
+void CommandTable::IndexCommandNames(UInt32 index)
+{
+	CommandInfo &cmdInfo = m_commands[index];
+	UInt32 *idxPtr;
+	if (m_nameIndex.Insert(cmdInfo.longName, &idxPtr))
+		*idxPtr = index;
+	if (cmdInfo.shortName && m_nameIndex.Insert(cmdInfo.shortName, &idxPtr))
+		*idxPtr = index;
+}
+
+void CommandTable::BuildNameIndex(void)
+{
+	m_nameIndex.Clear();
+	for (UInt32 index = 0; index < m_commands.size(); index++)
+		IndexCommandNames(index);
+	m_nameIndexValid = true;
+}
+
 CommandInfo * CommandTable::GetByName(const char * name)
 {
-	for (CommandList::iterator iter = m_commands.begin(); iter != m_commands.end(); ++iter)
-		if (!StrCompare(name, iter->longName) || (iter->shortName && !StrCompare(name, iter->shortName)))
-			return &(*iter);
+	ScopedLock lock(m_nameIndexLock);
+	if (!m_nameIndexValid)
+		BuildNameIndex();
 
-	return NULL;
+	UInt32 *idxPtr = m_nameIndex.GetPtr(name);
+	return idxPtr ? &m_commands[*idxPtr] : NULL;
+}
+
+UInt32 CommandTable::GetByNames(const char ** names, UInt32 numNames, CommandInfo ** outCommands)
+{
+	ScopedLock lock(m_nameIndexLock);
+	if (!m_nameIndexValid)
+		BuildNameIndex();
+
+	UInt32 numFound = 0, *idxPtr;
+	for (UInt32 i = 0; i < numNames; i++)
+	{
+		idxPtr = m_nameIndex.GetPtr(names[i]);
+		if (idxPtr)
+		{
+			outCommands[i] = &m_commands[*idxPtr];
+			numFound++;
+		}
+		else outCommands[i] = NULL;
+	}
+	return numFound;
 }
 
 
@@ -1618,4 +1668,5 @@ namespace PluginAPI
 	UInt32 GetReqVersion(const CommandInfo* cmd) { return g_scriptCommands.GetRequiredNVSEVersion(cmd); }
 	const PluginInfo* GetCmdParentPlugin(const CommandInfo* cmd) { return g_scriptCommands.GetParentPlugin(cmd); }
 	const PluginInfo* GetPluginInfoByName(const char *pluginName) {	return g_pluginManager.GetInfoByName(pluginName); }
+	UInt32 GetCmdsByNames(const char** names, UInt32 numNames, const CommandInfo** outCommands) { return g_scriptCommands.GetByNames(names, numNames, const_cast<CommandInfo**>(outCommands)); }
 }
@@ -3,6 +3,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "common/ICriticalSection.h"
+
 class TESObjectREFR;
 class Script;
 struct ScriptEventList;
@@ -256,6 +258,7 @@ public:
 	CommandInfo *	GetStart(void)	{ return &m_commands[0]; }
 	CommandInfo *	GetEnd(void)	{ return GetStart() + m_commands.size(); }
 	CommandInfo *	GetByName(const char * name);
+	UInt32			GetByNames(const char ** names, UInt32 numNames, CommandInfo ** outCommands);	// returns # found, missing ones are NULL
 	CommandInfo *	GetByOpcode(UInt32 opcode);
 
 	void	SetBaseID(UInt32 id)	{ m_baseID = id; m_curID = id; }
@@ -283,9 +286,13 @@ private:
 
 	typedef std::vector <CommandInfo>				CommandList;
 	typedef UnorderedMap<UInt32, CommandMetadata>	CmdMetadataList;
+	typedef UnorderedMap<const char*, UInt32>		CmdNameIndex;
 
 	CommandList		m_commands;
 	CmdMetadataList	m_metadata;
+	CmdNameIndex	m_nameIndex;		// long and short names (case-insensitive) -> index in m_commands of the first command using it
+	bool			m_nameIndexValid;
+	ICriticalSection	m_nameIndexLock;	// plugins may look commands up from other threads
 
 	UInt32		m_baseID;
 	UInt32		m_curID;
@@ -294,6 +301,9 @@ private:
 
 	void	RecordReleaseVersion(void);
 	void	RemoveDisabledPlugins(void);
+
+	void	IndexCommandNames(UInt32 index);
+	void	BuildNameIndex(void);
 };
 
 extern CommandTable	g_consoleCommands;
@@ -309,4 +319,5 @@ namespace PluginAPI
 	UInt32 GetReqVersion(const CommandInfo* cmd);
 	const PluginInfo* GetCmdParentPlugin(const CommandInfo* cmd);
 	const PluginInfo* GetPluginInfoByName(const char *pluginName);
+	UInt32 GetCmdsByNames(const char** names, UInt32 numNames, const CommandInfo** outCommands);
 }
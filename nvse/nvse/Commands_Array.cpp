@@ -163,13 +163,22 @@ bool Cmd_ar_Construct_Execute(COMMAND_ARGS)
 		return true;
 
 	UInt8 keyType = kDataType_Numeric;
-	bool bPacked = false;
+	bool bPacked = false, bHashed = false;
 	if (!StrCompare(arType, "StringMap"))
 		keyType = kDataType_String;
+	else if (!StrCompare(arType, "HashStringMap"))
+	{
+		keyType = kDataType_String;
+		bHashed = true;
+	}
+	else if (!StrCompare(arType, "HashMap"))
+		bHashed = true;
 	else if (StrCompare(arType, "Map") != 0)
 		bPacked = true;
 
 	ArrayVar *newArr = g_ArrayMap.Create(keyType, bPacked, scriptObj->GetModIndex());
+	if (bHashed)
+		newArr->UseHashedStorage();
 	*result = (int)newArr->ID();
 	return true;
 }
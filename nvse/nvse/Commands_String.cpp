@@ -196,12 +196,11 @@ bool StringVar_Find_Execute(COMMAND_ARGS, UInt32 mode, CommandInfo* commandInfo)
 			break;
 		case eMode_svReplace:
 			{
-				std::string str(toFind);
-				UInt32 splitPoint = str.find(GetSeparatorChar(scriptObj));
-				if (splitPoint != -1 && splitPoint < str.length())
+				char* separator = strchr(toFind, GetSeparatorChar(scriptObj));
+				if (separator)
 				{
-					toFind[splitPoint] = '\0';
-					char* replaceWith = (splitPoint == str.length() - 1) ? "" : toFind + splitPoint + 1;
+					*separator = '\0';
+					const char* replaceWith = separator + 1;
 					intResult = strVar->Replace(toFind, replaceWith, startPos, numChars, bCaseSensitive ? true : false, numToReplace);
 				}
 				break;
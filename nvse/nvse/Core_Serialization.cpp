@@ -6,6 +6,7 @@
 #include "StringVar.h"
 #include "ArrayVar.h"
 #include "ScriptTokens.h"
+#include "EventManager.h"
 
 /*************************
 Save file format:
@@ -23,6 +24,33 @@ Save file format:
 static ModInfo** s_ModFixupTable = NULL;
 bool LoadModList(NVSESerializationInterface* nvse);	// reads saved mod order, builds table mapping changed mod indexes
 
+// one line per save, so temporary var churn and pool growth over a session can be followed in nvse.log
+static void LogMemoryStats()
+{
+	const auto &arrayStats = g_ArrayMap.GetCleanStats(), &stringStats = g_StringMap.GetCleanStats();
+	_MESSAGE("SAVE: arrays live %d pending %d max clean pause %dus, strings live %d pending %d max clean pause %dus",
+		arrayStats.numLive, arrayStats.numPending, arrayStats.maxPauseMicro, stringStats.numLive, stringStats.numPending, stringStats.maxPauseMicro);
+
+	PoolClassStats poolStats[POOL_NUM_CLASSES];
+	Pool_GetStats(poolStats);
+	UInt32 hits = 0, refills = 0, depotReturns = 0, bytesReserved = 0;
+	for (UInt32 classIdx = 0; classIdx < POOL_NUM_CLASSES; classIdx++)
+	{
+		hits += poolStats[classIdx].hits;
+		refills += poolStats[classIdx].refills;
+		depotReturns += poolStats[classIdx].depotReturns;
+		bytesReserved += poolStats[classIdx].bytesReserved;
+	}
+	if (bytesReserved)	// no stats in debug builds
+		_MESSAGE("SAVE: pool hits %d refills %d depot returns %d reserved %dKB", hits, refills, depotReturns, bytesReserved >> 10);
+
+	EventManager::DeferredEventStats eventStats;
+	EventManager::GetDeferredEventStats(&eventStats);
+	if (eventStats.queued || eventStats.dropped)
+		_MESSAGE("SAVE: deferred events queued %d coalesced %d dropped %d dispatched %d pending %d",
+			eventStats.queued, eventStats.coalesced, eventStats.dropped, eventStats.dispatched, eventStats.pending);
+}
+
 /*******************************
 *	Callbacks
 *******************************/
@@ -48,6 +76,7 @@ void Core_SaveCallback(void * reserved)
 #endif
 	g_ArrayMap.Save(intfc);
 	g_StringMap.Save(intfc);
+	LogMemoryStats();
 }
 
 void Core_LoadCallback(void * reserved)
@@ -36,6 +36,57 @@ enum {
 typedef void (* EventHookInstaller)();
 
 typedef LinkedList<EventCallback>	CallbackList;
+typedef Vector<EventCallback*>		CallbackPtrList;
+
+// Callbacks of one event bucketed by filter, so that dispatch only visits those that can match.
+// Every list is kept in registration order; entries are only removed from Tick(), never mid-dispatch.
+struct CallbackIndex
+{
+	UnorderedMap<TESForm*, CallbackPtrList>	bySource;
+	UnorderedMap<TESForm*, CallbackPtrList>	byObject;		// object filter only
+	CallbackPtrList							unfiltered;
+
+	CallbackIndex() : bySource(0x20), byObject(0x20) {}
+	CallbackIndex(const CallbackIndex&) = delete;
+	CallbackIndex& operator=(const CallbackIndex&) = delete;
+
+	void Add(EventCallback *callback)
+	{
+		if (callback->source)
+			bySource[callback->source].Append(callback);
+		else if (callback->object)
+			byObject[callback->object].Append(callback);
+		else unfiltered.Append(callback);
+	}
+
+	void Remove(EventCallback *callback)
+	{
+		if (callback->source)
+		{
+			CallbackPtrList *list = bySource.GetPtr(callback->source);
+			if (list && list->Remove(callback) && list->Empty())
+				bySource.Erase(callback->source);
+		}
+		else if (callback->object)
+		{
+			CallbackPtrList *list = byObject.GetPtr(callback->object);
+			if (list && list->Remove(callback) && list->Empty())
+				byObject.Erase(callback->object);
+		}
+		else unfiltered.Remove(callback);
+	}
+
+	void Rebuild(CallbackList &callbacks)
+	{
+		bySource.Clear();
+		byObject.Clear();
+		unfiltered.Clear();
+		for (auto iter = callbacks.Begin(); !iter.End(); ++iter)
+			Add(&iter.Get());
+	}
+};
+
+static UInt32 s_callbackOrder = 0;
 
 UnorderedMap<const char*, UInt32> s_eventNameToID(0x40);
 
@@ -66,12 +117,14 @@ struct EventInfo
 		eventMask(other.eventMask), 
 		installHook(other.installHook)
 		{ 
+			index.Rebuild(callbacks);
 		}
 	EventInfo& operator=(const EventInfo& other) {
 		evName = other.evName;
 		paramTypes = other.paramTypes;
 		numParams = other.numParams;
 		callbacks = other.callbacks;
+		index.Rebuild(callbacks);
 		eventMask = other.eventMask;
 		installHook = other.installHook;
 		return *this;
@@ -82,6 +135,7 @@ struct EventInfo
 	UInt8				numParams;
 	UInt32				eventMask;
 	CallbackList		callbacks;
+	CallbackIndex		index;
 	EventHookInstaller	*installHook;	// if a hook is needed for this event type, this will be non-null. 
 										// install it once and then set *installHook to NULL. Allows multiple events
 										// to use the same hook, installing it only once.
@@ -472,32 +526,133 @@ __declspec(naked) bool __fastcall IsValidReference(void *object)
 // used by GetCurrentEventName
 Stack<const char*> s_eventStack;
 
-// some events are best deferred until Tick() invoked rather than being handled immediately
-// this stores info about such an event. Currently unused.
-struct DeferredCallback
+// Events raised outside the main thread are handled on the next Tick() instead.
+// Producers push onto an intrusive MPSC queue (Vyukov) with a single exchange, Tick() is the only consumer.
+struct DeferredEvent
 {
-	EventCallback		*callback;
-	void				*arg0;
-	void				*arg1;
-	EventInfo			*eventInfo;
+	DeferredEvent	*next;
+	UInt32			eventID;
+	void			*arg0;
+	void			*arg1;
+};
 
-	DeferredCallback(EventCallback *pCallback, void *_arg0, void *_arg1, EventInfo *_eventInfo) : callback(pCallback), arg0(_arg0), arg1(_arg1), eventInfo(_eventInfo) {}
+#define DEFERRED_EVENTS_MAX		0x10000		// queued + pending entries beyond this are dropped
+
+static DeferredEvent s_deferredStub = {NULL, 0, NULL, NULL};
+static DeferredEvent *volatile s_deferredTail = &s_deferredStub;	// producers
+static DeferredEvent *s_deferredHead = &s_deferredStub;				// consumer
+static volatile LONG s_numDeferred = 0;
+static DeferredEventStats s_deferredStats = {0, 0, 0, 0, 0};
+
+// drained but not yet dispatched, in arrival order; main thread only
+static Vector<DeferredEvent> s_pendingEvents(0x40);
+
+// eventID -> (arg0, arg1) of pending entries, only for events with coalescing enabled
+static UnorderedMap<UInt32, UnorderedSet<UInt64>> s_coalescedEvents;
+
+static void PushDeferred(DeferredEvent *node)
+{
+	node->next = NULL;
+	DeferredEvent *prev = (DeferredEvent*)InterlockedExchangePointer((void*volatile*)&s_deferredTail, node);
+	prev->next = node;
+}
 
-	~DeferredCallback()
+static DeferredEvent *PopDeferred()
+{
+	DeferredEvent *head = s_deferredHead, *next = head->next;
+	if (head == &s_deferredStub)
+	{
+		if (!next) return NULL;
+		s_deferredHead = head = next;
+		next = next->next;
+	}
+	if (next)
 	{
-		if (callback->removed) return;
+		s_deferredHead = next;
+		return head;
+	}
+	// a producer is between its exchange and linking, pick it up next frame
+	if (head != s_deferredTail) return NULL;
+	PushDeferred(&s_deferredStub);
+	next = head->next;
+	if (next)
+	{
+		s_deferredHead = next;
+		return head;
+	}
+	return NULL;
+}
 
-		s_eventStack.Push(eventInfo->evName);
-		ScriptToken *result = UserFunctionManager::Call(EventHandlerCaller(callback->script, eventInfo, arg0, arg1));
-		s_eventStack.Pop();
+static void DeferEvent(UInt32 eventID, void *arg0, void *arg1)
+{
+	if (InterlockedIncrement(&s_numDeferred) > DEFERRED_EVENTS_MAX)
+	{
+		InterlockedDecrement(&s_numDeferred);
+		InterlockedIncrement((LONG*)&s_deferredStats.dropped);
+		return;
+	}
+	InterlockedIncrement((LONG*)&s_deferredStats.queued);
+	DeferredEvent *node = ALLOC_NODE(DeferredEvent);
+	node->eventID = eventID;
+	node->arg0 = arg0;
+	node->arg1 = arg1;
+	PushDeferred(node);
+}
 
-		// result is unused
-		if (result) delete result;
+__forceinline UInt64 DeferredArgsKey(void *arg0, void *arg1)
+{
+	return ((UInt64)(UInt32)arg0 << 32) | (UInt32)arg1;
+}
+
+// moves newly queued events behind the ones carried over, then dispatches until the budget (microseconds, 0 = none) is spent
+static void DispatchDeferredEvents(UInt32 budgetMicro)
+{
+	while (DeferredEvent *node = PopDeferred())
+	{
+		UnorderedSet<UInt64> *pending = s_coalescedEvents.Empty() ? NULL : s_coalescedEvents.GetPtr(node->eventID);
+		if (pending && !pending->Insert(DeferredArgsKey(node->arg0, node->arg1)))
+		{
+			InterlockedDecrement(&s_numDeferred);
+			s_deferredStats.coalesced++;
+		}
+		else s_pendingEvents.Append(*node);
+		Pool_Free(node, sizeof(DeferredEvent));
 	}
-};
+	if (s_pendingEvents.Empty()) return;
 
-typedef Stack<DeferredCallback> DeferredCallbackList;
-DeferredCallbackList s_deferredCallbacks;
+	static LARGE_INTEGER s_qpcFreq = {};
+	LARGE_INTEGER startTime, curTime;
+	if (budgetMicro)
+	{
+		if (!s_qpcFreq.QuadPart)
+			QueryPerformanceFrequency(&s_qpcFreq);
+		QueryPerformanceCounter(&startTime);
+	}
+	LONGLONG budgetCounts = (s_qpcFreq.QuadPart * budgetMicro) / 1000000;
+
+	UInt32 numDispatched = 0, numPending = s_pendingEvents.Size();
+	do
+	{
+		// copied out, handlers may register new events
+		DeferredEvent deferred = s_pendingEvents[numDispatched++];
+		if (!s_coalescedEvents.Empty())
+			if (UnorderedSet<UInt64> *pending = s_coalescedEvents.GetPtr(deferred.eventID))
+				pending->Erase(DeferredArgsKey(deferred.arg0, deferred.arg1));
+		HandleEvent(deferred.eventID, deferred.arg0, deferred.arg1);
+		if (budgetMicro)
+		{
+			QueryPerformanceCounter(&curTime);
+			if ((curTime.QuadPart - startTime.QuadPart) >= budgetCounts)
+				break;
+		}
+	}
+	while (numDispatched < numPending);
+
+	s_pendingEvents.RemoveRange(0, numDispatched);
+	InterlockedExchangeAdd(&s_numDeferred, -(LONG)numDispatched);
+	s_deferredStats.dispatched += numDispatched;
+	s_deferredStats.pending = s_pendingEvents.Size();
+}
 
 struct DeferredRemoveCallback
 {
@@ -510,6 +665,7 @@ struct DeferredRemoveCallback
 	{
 		if (iterator.Get().removed)
 		{
+			eventInfo->index.Remove(&iterator.Get());
 			eventInfo->callbacks.Remove(iterator);
 			if (eventInfo->callbacks.Empty() && eventInfo->eventMask)
 				s_eventsInUse &= ~eventInfo->eventMask;
@@ -523,43 +679,75 @@ DeferredRemoveList s_deferredRemoveList;
 
 void __stdcall HandleEvent(UInt32 id, void* arg0, void* arg1)
 {
+	if (GetCurrentThreadId() != g_mainThreadID)
+	{
+		// avoid potential issues with invoking handlers outside of main thread by deferring event handling
+		// events nobody handles are dropped here rather than taking up room in the queue
+		{
+			ScopedLock lock(s_criticalSection);
+			if (s_eventInfos[id].callbacks.Empty())
+				return;
+		}
+		DeferEvent(id, arg0, arg1);
+		return;
+	}
+
 	ScopedLock lock(s_criticalSection);
 
 	EventInfo* eventInfo = &s_eventInfos[id];
 	if (eventInfo->callbacks.Empty()) return;
 
-	for (auto iter = eventInfo->callbacks.Begin(); !iter.End(); ++iter)
+	// gather the lists that can match, then walk them merged by registration order
+	// lists are indexed rather than iterated by pointer, as handlers may register more callbacks
+	CallbackIndex &index = eventInfo->index;
+	CallbackPtrList *lists[4];
+	UInt32 positions[4] = {0, 0, 0, 0}, numLists = 0;
+	if (!index.bySource.Empty())
 	{
-		EventCallback &callback = iter.Get();
-
-		if (callback.IsRemoved())
-			continue;
+		if (CallbackPtrList *list = index.bySource.GetPtr((TESForm*)arg0))
+			lists[numLists++] = list;
+		if (IsValidReference(arg0))
+			if (CallbackPtrList *list = index.bySource.GetPtr(((TESObjectREFR*)arg0)->baseForm))
+				lists[numLists++] = list;
+	}
+	if (arg1 && !index.byObject.Empty())
+		if (CallbackPtrList *list = index.byObject.GetPtr((TESForm*)arg1))
+			lists[numLists++] = list;
+	if (!index.unfiltered.Empty())
+		lists[numLists++] = &index.unfiltered;
 
-		// Check filters
-		if (callback.source && (arg0 != callback.source))
+	while (true)
+	{
+		EventCallback *pCallback = NULL, *pCandidate;
+		UInt32 nextList = 0;
+		for (UInt32 i = 0; i < numLists; i++)
 		{
-			if (!IsValidReference(arg0) || (((TESObjectREFR*)arg0)->baseForm != callback.source))
-				continue;
+			if (positions[i] >= lists[i]->Size()) continue;
+			pCandidate = (*lists[i])[positions[i]];
+			if (!pCallback || (pCandidate->order < pCallback->order))
+			{
+				pCallback = pCandidate;
+				nextList = i;
+			}
 		}
+		if (!pCallback) break;
+		positions[nextList]++;
+
+		EventCallback &callback = *pCallback;
+
+		if (callback.IsRemoved())
+			continue;
 
+		// source filter is implied by the list, object filter still needs checking
 		if (callback.object && (callback.object != arg1))
 			continue;
 
-		if (GetCurrentThreadId() != g_mainThreadID)
-		{
-			// avoid potential issues with invoking handlers outside of main thread by deferring event handling
-			s_deferredCallbacks.Push(&callback, arg0, arg1, eventInfo);
-		}
-		else
-		{
-			// handle immediately
-			s_eventStack.Push(eventInfo->evName);
-			ScriptToken* result = UserFunctionManager::Call(EventHandlerCaller(callback.script, eventInfo, arg0, arg1));
-			s_eventStack.Pop();
+		s_eventStack.Push(eventInfo->evName);
+		ScriptToken* result = UserFunctionManager::Call(EventHandlerCaller(callback.script, eventInfo, arg0, arg1));
+		s_eventStack.Pop();
 
-			// result is unused
-			if (result)	delete result;
-		}
+		// result is unused
+		if (result)	delete result;
 	}
 }
 
@@ -652,7 +840,9 @@ bool SetHandler(const char* eventName, EventCallback& handler)
 			}
 		}
 
-		info->callbacks.Append(handler);
+		EventCallback *newCallback = info->callbacks.Append(handler);
+		newCallback->order = ++s_callbackOrder;
+		info->index.Add(newCallback);
 
 		s_eventsInUse |= info->eventMask;
 
@@ -831,7 +1021,28 @@ void Tick()
 	ScopedLock lock(s_criticalSection);
 
 	// handle deferred events
-	s_deferredCallbacks.Clear();
+	static UInt32 s_deferredEventBudget = 0xFFFFFFFF;
+	if (s_deferredEventBudget == 0xFFFFFFFF)
+	{
+		s_deferredEventBudget = 0;
+		GetNVSEConfigOption_UInt32("EVENTS", "DeferredEventBudgetMicro", &s_deferredEventBudget);
+
+		// comma separated event names; read on the first frame so events registered by plugins are known
+		std::string coalesced = GetNVSEConfigOption("EVENTS", "CoalescedDeferredEvents");
+		for (size_t start = 0; start < coalesced.size();)
+		{
+			size_t end = coalesced.find(',', start);
+			if (end == std::string::npos)
+				end = coalesced.size();
+			std::string eventName = coalesced.substr(start, end - start);
+			eventName.erase(0, eventName.find_first_not_of(" \t"));
+			eventName.erase(eventName.find_last_not_of(" \t") + 1);
+			if (!eventName.empty() && !SetDeferredCoalescing(eventName.c_str(), true))
+				_MESSAGE("CoalescedDeferredEvents: unknown event %s", eventName.c_str());
+			start = end + 1;
+		}
+	}
+	DispatchDeferredEvents(s_deferredEventBudget);
 
 	// Clear callbacks pending removal.
 	s_deferredRemoveList.Clear();
@@ -845,6 +1056,25 @@ void Tick()
 	s_lastOnHitAttacker = NULL;
 }
 
+void GetDeferredEventStats(DeferredEventStats *outStats)
+{
+	*outStats = s_deferredStats;
+}
+
+bool SetDeferredCoalescing(const char* eventName, bool bCoalesce)
+{
+	ScopedLock lock(s_criticalSection);
+
+	UInt32 eventID = EventIDForString(eventName);
+	if (eventID == kEventID_INVALID)
+		return false;
+	if (bCoalesce)
+		s_coalescedEvents[eventID];
+	else
+		s_coalescedEvents.Erase(eventID);
+	return true;
+}
+
 void Init()
 {
 #define EVENT_INFO(name, params, hookInstaller, eventMask) s_eventInfos.Append(name, params, params ? sizeof(params) : 0, eventMask, hookInstaller)
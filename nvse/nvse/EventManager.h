@@ -79,14 +79,15 @@ namespace EventManager
 	// Represents an event handler registered for an event.
 	struct EventCallback
 	{
-		EventCallback() : script(NULL), source(NULL), object(NULL), removed(false), pendingRemove(false) {}
+		EventCallback() : script(NULL), source(NULL), object(NULL), order(0), removed(false), pendingRemove(false) {}
 		EventCallback(Script* funcScript, TESForm* sourceFilter = NULL, TESForm* objectFilter = NULL)
-			: script(funcScript), source(sourceFilter), object(objectFilter), removed(false), pendingRemove(false) {}
+			: script(funcScript), source(sourceFilter), object(objectFilter), order(0), removed(false), pendingRemove(false) {}
 		EventCallback& operator=(const EventCallback& other)
 		{
 			script = other.script;
 			source = other.source;
 			object = other.object;
+			order = other.order;
 			removed = other.removed;
 			pendingRemove = other.pendingRemove;
 			return *this;
@@ -95,6 +96,7 @@ namespace EventManager
 		Script			*script;
 		TESForm			*source;				// first arg to handler (reference or base form or form list)
 		TESForm			*object;				// second arg to handler
+		UInt32			order;					// registration sequence, dispatch follows it
 		bool			removed;
 		bool			pendingRemove;
 
@@ -120,6 +122,20 @@ namespace EventManager
 	// called each frame to update internal state
 	void Tick();
 
+	// HandleEvent calls made off the main thread are queued and dispatched from Tick()
+	struct DeferredEventStats
+	{
+		UInt32		queued;			// accepted into the queue
+		UInt32		coalesced;		// dropped as identical to an entry still pending
+		UInt32		dropped;		// rejected because the queue was full
+		UInt32		dispatched;
+		UInt32		pending;		// carried over to the next frame by the time budget
+	};
+	void GetDeferredEventStats(DeferredEventStats *outStats);
+
+	// when enabled, a deferred event is skipped if the same (arg0, arg1) is already waiting for Tick()
+	bool SetDeferredCoalescing(const char* eventName, bool bCoalesce);
+
 	void Init();
 
 	// dispatch a user-defined event from a script
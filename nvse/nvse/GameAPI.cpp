@@ -972,6 +972,249 @@ UInt32 ScriptEventList::Var::GetFormId()
 
 #if NVSE_CORE
 
+#if RUNTIME
+// Format strings stored as literals in script bytecode are compiled once into a list of literal runs and
+// specifier ops, keyed by script and bytecode position. Strings using specifiers not handled here are
+// cached as unsupported and go straight to ExtractFormattedString.
+struct CompiledFormatString
+{
+	enum
+	{
+		kOp_Literal,
+		kOp_Float,		// %f/%g with optional flags, width and precision; spec text passed to snprintf
+		kOp_Name,		// %n
+		kOp_FormID,		// %i
+		kOp_StringVar,	// %z
+	};
+
+	struct Op
+	{
+		UInt8		type;
+		UInt16		length;		// literal run length
+		UInt32		offset;		// into text: literal run, or null-terminated spec
+	};
+
+	UInt16		srcLen;
+	UInt16		numOps;
+	bool		supported;
+	const char	*source;
+	const Op	*ops;
+	const char	*text;
+
+	bool Matches(const char *src, UInt32 len) const {return (srcLen == len) && !memcmp(source, src, len);}
+
+	static CompiledFormatString *Create(const char *src, UInt32 len);
+	bool Execute(FormatStringArgs &args, char *buffer) const;
+};
+
+CompiledFormatString *CompiledFormatString::Create(const char *src, UInt32 len)
+{
+	// worst case every character is its own op; text holds literals plus specs with their terminators
+	Op *tmpOps = (Op*)malloc(sizeof(Op) * (len + 1));
+	char *tmpText = (char*)malloc((len * 2) + 1);
+	UInt32 numOps = 0, textLen = 0;
+	bool supported = true;
+
+	auto AddOp = [&](UInt8 type)
+	{
+		Op &op = tmpOps[numOps++];
+		op.type = type;
+		op.length = 0;
+		op.offset = textLen;
+	};
+	auto AddLiteral = [&](char chr)
+	{
+		if (!numOps || (tmpOps[numOps - 1].type != kOp_Literal))
+			AddOp(kOp_Literal);
+		tmpOps[numOps - 1].length++;
+		tmpText[textLen++] = chr;
+	};
+
+	for (UInt32 idx = 0; supported && (idx < len); idx++)
+	{
+		if (src[idx] != '%')
+		{
+			AddLiteral(src[idx]);
+			continue;
+		}
+		if (++idx == len)
+		{
+			supported = false;
+			break;
+		}
+		switch (src[idx])
+		{
+			case '%':
+				AddLiteral('%');
+				break;
+			case 'r':
+				AddLiteral('\n');
+				break;
+			case 'q':
+				AddLiteral('"');
+				break;
+			case 'e':
+				break;
+			case 'n':
+				AddOp(kOp_Name);
+				break;
+			case 'i':
+				AddOp(kOp_FormID);
+				break;
+			case 'z':
+				AddOp(kOp_StringVar);
+				break;
+			default:
+			{
+				UInt32 specStart = idx - 1;
+				while ((idx < len) && strchr("-+ #0", src[idx])) idx++;
+				while ((idx < len) && isdigit((UInt8)src[idx])) idx++;
+				if ((idx < len) && (src[idx] == '.'))
+					for (idx++; (idx < len) && isdigit((UInt8)src[idx]); idx++);
+				if ((idx == len) || ((src[idx] != 'f') && (src[idx] != 'g')))
+				{
+					supported = false;
+					break;
+				}
+				AddOp(kOp_Float);
+				UInt32 specLen = idx + 1 - specStart;
+				memcpy(tmpText + textLen, src + specStart, specLen);
+				textLen += specLen;
+				tmpText[textLen++] = 0;
+				break;
+			}
+		}
+	}
+
+	if (!supported) numOps = textLen = 0;
+	UInt32 opsSize = sizeof(Op) * numOps;
+	auto result = (CompiledFormatString*)malloc(sizeof(CompiledFormatString) + opsSize + len + textLen);
+	Op *ops = (Op*)(result + 1);
+	char *source = (char*)ops + opsSize;
+	char *text = source + len;
+	memcpy(ops, tmpOps, opsSize);
+	memcpy(source, src, len);
+	memcpy(text, tmpText, textLen);
+	result->srcLen = len;
+	result->numOps = numOps;
+	result->supported = supported;
+	result->source = source;
+	result->ops = ops;
+	result->text = text;
+
+	free(tmpOps);
+	free(tmpText);
+	return result;
+}
+
+bool CompiledFormatString::Execute(FormatStringArgs &args, char *buffer) const
+{
+	char *out = buffer, *outEnd = buffer + kMaxMessageLength - 1;
+	char numBuf[0x10];
+	for (const Op *op = ops, *opEnd = ops + numOps; op < opEnd; op++)
+	{
+		const char *str;
+		UInt32 length;
+		switch (op->type)
+		{
+			case kOp_Literal:
+				str = text + op->offset;
+				length = op->length;
+				break;
+			case kOp_Float:
+			{
+				double value;
+				if (!args.Arg(FormatStringArgs::kArgType_Float, &value))
+					return false;
+				SInt32 written = snprintf(out, outEnd - out + 1, text + op->offset, value);
+				if (written > 0)
+					out += ((UInt32)written < (UInt32)(outEnd - out)) ? written : (outEnd - out);
+				continue;
+			}
+			case kOp_Name:
+			case kOp_FormID:
+			{
+				TESForm *form = NULL;
+				if (!args.Arg(FormatStringArgs::kArgType_Form, &form))
+					return false;
+				if (op->type == kOp_Name)
+				{
+					str = GetFullName(form);
+					length = StrLen(str);
+				}
+				else
+				{
+					length = sprintf_s(numBuf, "%08X", form ? form->refID : 0);
+					str = numBuf;
+				}
+				break;
+			}
+			default:
+			{
+				double value;
+				if (!args.Arg(FormatStringArgs::kArgType_Float, &value))
+					return false;
+				str = StringFromStringVar((UInt32)value);
+				length = StrLen(str);
+				break;
+			}
+		}
+		if (length > (UInt32)(outEnd - out))
+			length = outEnd - out;
+		memcpy(out, str, length);
+		out += length;
+	}
+	*out = 0;
+	return true;
+}
+
+#define COMPILED_FORMATS_MAX	0x2000
+
+static UnorderedMap<UInt64, CompiledFormatString*> s_compiledFormats;
+static ICriticalSection s_compiledFormatsCS;
+
+// fmtData points at the length-prefixed format string literal in the script data
+static bool ExtractCompiledFormatString(FormatStringArgs &args, Script *scriptObj, const UInt8 *fmtData, char *buffer)
+{
+	UInt32 srcLen = *(UInt16*)fmtData;
+	const char *src = (const char*)(fmtData + 2);
+	// '$' names a string var, so the actual format string is only known at runtime
+	if (!scriptObj || !srcLen || (*src == '$'))
+		return ExtractFormattedString(args, buffer);
+
+	UInt64 key = ((UInt64)(UInt32)scriptObj << 32) | (UInt32)(fmtData - (const UInt8*)scriptObj->data);
+	ScopedLock lock(s_compiledFormatsCS);
+	CompiledFormatString **pCompiled;
+	if (s_compiledFormats.Insert(key, &pCompiled))
+	{
+		// temporary scripts are never evicted individually, so start over once the cache gets large
+		if (s_compiledFormats.Size() > COMPILED_FORMATS_MAX)
+		{
+			for (auto iter = s_compiledFormats.Begin(); !iter.End(); ++iter)
+				if (iter.Get()) free(iter.Get());
+			s_compiledFormats.Clear();
+			s_compiledFormats.Insert(key, &pCompiled);
+		}
+		*pCompiled = CompiledFormatString::Create(src, srcLen);
+	}
+	// the script may have been recompiled or freed and its address reused
+	else if (!(*pCompiled)->Matches(src, srcLen))
+	{
+		free(*pCompiled);
+		*pCompiled = CompiledFormatString::Create(src, srcLen);
+	}
+
+	if (!(*pCompiled)->supported)
+		return ExtractFormattedString(args, buffer);
+	return (*pCompiled)->Execute(args, buffer);
+}
+#else
+static bool ExtractCompiledFormatString(FormatStringArgs &args, Script *scriptObj, const UInt8 *fmtData, char *buffer)
+{
+	return ExtractFormattedString(args, buffer);
+}
+#endif
+
 //fmtStringPos is index of fmtString param in paramInfo, with first param = 0
 bool ExtractFormatStringArgs(UInt32 fmtStringPos, char* buffer, ParamInfo * paramInfo, void * scriptDataIn, UInt32 * scriptDataOffset, Script * scriptObj, ScriptEventList * eventList, UInt32 maxParams, ...)
 {
@@ -1002,7 +1245,7 @@ bool ExtractFormatStringArgs(UInt32 fmtStringPos, char* buffer, ParamInfo * para
 	}
 
 	ScriptFormatStringArgs scriptArgs(numArgs, scriptData, scriptObj, eventList);
-	bExtracted = ExtractFormattedString(scriptArgs, buffer);
+	bExtracted = ExtractCompiledFormatString(scriptArgs, scriptObj, scriptData, buffer);
 
 	numArgs = scriptArgs.GetNumArgs();
 	scriptData = scriptArgs.GetScriptData();
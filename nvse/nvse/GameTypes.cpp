@@ -92,10 +92,8 @@ bool BSString::Includes(const char *toFind) const
 {
 	if (!m_data || !toFind)		//passing null ptr to std::string c'tor = CRASH
 		return false;
-	std::string curr(m_data, m_dataLen);
-	std::string str2(toFind);
-	std::string::iterator currEnd = curr.end();
-	return (std::search(curr.begin(), currEnd, str2.begin(), str2.end(), ci_equal) != currEnd);
+	SubStrFinder finder(toFind, StrLen(toFind), false);
+	return finder.Find(m_data, m_dataLen, 0) != -1;
 }
 
 bool BSString::Replace(const char *_toReplace, const char *_replaceWith)
@@ -103,17 +101,12 @@ bool BSString::Replace(const char *_toReplace, const char *_replaceWith)
 	if (!m_data || !_toReplace)
 		return false;
 
-	std::string curr(m_data, m_dataLen);
-	std::string toReplace(_toReplace);
-
-	std::string::iterator currBegin = curr.begin();
-	std::string::iterator currEnd = curr.end();
-	std::string::iterator replaceIt = std::search(currBegin, currEnd, toReplace.begin(), toReplace.end(), ci_equal);
-	if (replaceIt != currEnd) {
-		std::string replaceWith(_replaceWith);
+	SubStrFinder finder(_toReplace, StrLen(_toReplace), false);
+	UInt32 replacePos = finder.Find(m_data, m_dataLen, 0);
+	if (replacePos != -1) {
 		// we found the substring, now we need to do the modification
-		std::string::size_type replacePos = distance(currBegin, replaceIt);
-		curr.replace(replacePos, toReplace.size(), replaceWith);
+		std::string curr(m_data, m_dataLen);
+		curr.replace(replacePos, finder.Length(), _replaceWith);
 		Set(curr.c_str());
 		return true;
 	}
@@ -78,8 +78,15 @@ static void HandleMainLoopHook(void)
 	EventManager::Tick();
 
 	// clean up any temp arrays/strings (moved after deffered processing because of array parameter to User Defined Events)
-	g_ArrayMap.Clean();
-	g_StringMap.Clean();
+	// spread over frames when a budget is set, so scripts churning temporaries don't cause one long stall
+	static UInt32 s_tempVarCleanBudget = 0xFFFFFFFF;
+	if (s_tempVarCleanBudget == 0xFFFFFFFF)
+	{
+		s_tempVarCleanBudget = 1000;
+		GetNVSEConfigOption_UInt32("MEMORY", "TempVarCleanBudgetMicro", &s_tempVarCleanBudget);
+	}
+	g_ArrayMap.CleanTemporaries(s_tempVarCleanBudget);
+	g_StringMap.CleanTemporaries(s_tempVarCleanBudget);
 }
 
 #define DEBUG_PRINT_CHANNEL(idx)								\
@@ -185,6 +192,8 @@ void __stdcall SendQuitGameMessage(QuitGameMessage msg)
 
 	PluginManager::Dispatch_Message(0, msgToSend, NULL, 0, NULL);
 //	handled by Dispatch_Message EventManager::HandleNVSEMessage(msgToSend, NULL);
+	if (msg != kQuit_ToMainMenu)
+		Serialization::WaitForPendingSave();
 }
 
 __declspec(naked) void ExitGameFromMenuHook()
@@ -17,7 +17,8 @@ LoopManager* LoopManager::GetSingleton()
 	return localData.loopManager;
 }
 
-ArrayIterLoop::ArrayIterLoop(const ForEachContext* context, UInt8 modIndex)
+ArrayIterLoop::ArrayIterLoop(const ForEachContext* context, UInt8 modIndex) : m_srcArr(NULL), m_srcVersion(0),
+	m_iterArr(NULL), m_iterVersion(0), m_keyElem(NULL), m_valueElem(NULL)
 {
 	m_srcID = context->sourceID;
 	m_iterID = context->iteratorID;
@@ -28,15 +29,23 @@ ArrayIterLoop::ArrayIterLoop(const ForEachContext* context, UInt8 modIndex)
 	g_ArrayMap.AddReference(&m_iterVar->data, context->iteratorID, 0xFF);
 
 	ArrayVar *arr = g_ArrayMap.Get(m_srcID);
-	if (arr)
+	if (arr && arr->GetFirstElement(&m_srcIter))
 	{
-		const ArrayKey *key;
-		ArrayElement *elem;
-		if (arr->GetFirstElement(&elem, &key))
-		{
-			m_curKey = *key;
-			UpdateIterator(elem);		// initialize iterator to first element in array
-		}
+		PinSource(arr);
+		m_curKey = *m_srcIter.first();
+		UpdateIterator(m_srcIter.second());		// initialize iterator to first element in array
+	}
+}
+
+void ArrayIterLoop::PinSource(ArrayVar* arr)
+{
+	// a copy-on-write copy iterates its source's container, which can move independently of it
+	if (arr->ReadsSharedElements())
+		m_srcArr = NULL;
+	else
+	{
+		m_srcArr = arr;
+		m_srcVersion = arr->LayoutVersion();
 	}
 }
 
@@ -45,34 +54,44 @@ void ArrayIterLoop::UpdateIterator(const ArrayElement* elem)
 	ArrayVar *arr = g_ArrayMap.Get(m_iterID);
 	if (!arr) return;
 
+	if ((arr != m_iterArr) || (arr->LayoutVersion() != m_iterVersion) || arr->IsShared())
+	{
+		m_keyElem = arr->Get("key", true);
+		m_valueElem = arr->Get("value", true);
+		m_iterArr = arr;
+		m_iterVersion = arr->LayoutVersion();
+	}
+
 	// iter["key"] = element key
-	ArrayElement *newElem = arr->Get("key", true);
-	if (newElem)
+	if (m_keyElem)
 	{
 		if (m_curKey.KeyType() == kDataType_String)
-			newElem->SetString(m_curKey.key.str);
-		else newElem->SetNumber(m_curKey.key.num);
+			m_keyElem->SetString(m_curKey.key.str);
+		else m_keyElem->SetNumber(m_curKey.key.num);
 	}
 	// iter["value"] = element data
-	newElem = arr->Get("value", true);
-	if (newElem) newElem->Set(elem);
+	if (m_valueElem) m_valueElem->Set(elem);
 }
 
 bool ArrayIterLoop::Update(COMMAND_ARGS)
 {
 	ArrayVar *arr = g_ArrayMap.Get(m_srcID);
-	if (arr)
+	if (!arr) return false;
+
+	if ((arr == m_srcArr) && (arr->LayoutVersion() == m_srcVersion))
 	{
-		ArrayElement *elem;
-		const ArrayKey *key;
-		if (arr->GetNextElement(&m_curKey, &elem, &key))
-		{
-			m_curKey = *key;
-			UpdateIterator(elem);	
-			return true;
-		}
+		// nothing was added or removed since the last iteration, step the kept iterator
+		++m_srcIter;
+		if (m_srcIter.End())
+			return false;
 	}
-	return false;
+	else if (arr->GetNextElement(&m_curKey, &m_srcIter))
+		PinSource(arr);
+	else return false;
+
+	m_curKey = *m_srcIter.first();
+	UpdateIterator(m_srcIter.second());
+	return true;
 }
 
 ArrayIterLoop::~ArrayIterLoop()
@@ -91,7 +110,10 @@ StringIterLoop::StringIterLoop(const ForEachContext* context)
 		m_curIndex = 0;
 		m_iterID = context->iteratorID;
 		if (m_src.length())
-			iterVar->Set(m_src.substr(0, 1).c_str());
+		{
+			char chr[2] = {m_src[0], 0};
+			iterVar->Set(chr);
+		}
 	}
 }
 
@@ -103,7 +125,8 @@ bool StringIterLoop::Update(COMMAND_ARGS)
 		m_curIndex++;
 		if (m_curIndex < m_src.length())
 		{
-			iterVar->Set(m_src.substr(m_curIndex, 1).c_str());
+			char chr[2] = {m_src[m_curIndex], 0};
+			iterVar->Set(chr);
 			return true;
 		}
 	}
@@ -48,6 +48,8 @@ public:
 };
 
 // iterates over elements of an Array
+// Keeps the source iterator and the iterator's "key"/"value" elements between iterations, falling back to
+// key lookups when either array's layout version changes (see ArrayVar::PrepareWrite).
 class ArrayIterLoop : public ForEachLoop
 {
 	ArrayID					m_srcID;
@@ -55,6 +57,15 @@ class ArrayIterLoop : public ForEachLoop
 	ArrayKey				m_curKey;
 	ScriptEventList::Var	*m_iterVar;
 
+	ArrayVar				*m_srcArr;
+	UInt32					m_srcVersion;
+	ArrayIterator			m_srcIter;
+	ArrayVar				*m_iterArr;
+	UInt32					m_iterVersion;
+	ArrayElement			*m_keyElem;
+	ArrayElement			*m_valueElem;
+
+	void PinSource(ArrayVar* arr);
 	void UpdateIterator(const ArrayElement* elem);
 public:
 	ArrayIterLoop(const ForEachContext* context, UInt8 modIndex);
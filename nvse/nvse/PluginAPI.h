@@ -557,7 +557,7 @@ struct NVSEArrayVarInterface
 struct NVSECommandTableInterface
 {
 	enum {
-		kVersion = 1
+		kVersion = 2
 	};
 
 	UInt32	version;
@@ -569,6 +569,8 @@ struct NVSECommandTableInterface
 	UInt32(*GetRequiredNVSEVersion)(const CommandInfo* cmd);
 	const PluginInfo* (*GetParentPlugin)(const CommandInfo* cmd);	// returns a pointer to the PluginInfo of the NVSE plugin that adds the command, if any. returns NULL otherwise
 	const PluginInfo* (*GetPluginInfoByName)(const char* pluginName);	// Returns a pointer to the PluginInfo of the NVSE plugin of the specified name; returns NULL is the plugin is not loaded.
+	// version 2+: looks up numNames commands at once, filling outCommands with NULL for names that don't exist. Returns the number found.
+	UInt32(*GetByNames)(const char** names, UInt32 numNames, const CommandInfo** outCommands);
 };
 
 /**** script API docs **********************************************************
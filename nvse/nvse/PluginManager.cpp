@@ -71,7 +71,8 @@ static const NVSECommandTableInterface g_NVSECommandTableInterface =
 	PluginAPI::GetCmdRetnType,
 	PluginAPI::GetReqVersion,
 	PluginAPI::GetCmdParentPlugin,
-	PluginAPI::GetPluginInfoByName
+	PluginAPI::GetPluginInfoByName,
+	PluginAPI::GetCmdsByNames
 };
 
 static const NVSEInterface g_NVSEInterface =
@@ -589,7 +589,7 @@ ScriptToken* Eval_PlusEquals_String(OperatorType op, ScriptToken* lh, ScriptToke
 		strVar = g_StringMap.Get(strID);
 	}
 
-	strVar->StringRef() += rh->GetString();
+	strVar->Append(rh->GetString());
 
 	return ScriptToken::Create(strVar->GetCString());
 }
@@ -607,7 +607,7 @@ ScriptToken* Eval_TimesEquals_String(OperatorType op, ScriptToken* lh, ScriptTok
 		strVar = g_StringMap.Get(strID);
 	}
 
-	std::string str = strVar->String();
+	std::string str(strVar->String());
 
 	int rhNum = rh->GetNumber();
 	while (rhNum > 0)
@@ -3,6 +3,8 @@
 #include "common/IFileStream.h"
 #include "PluginManager.h"
 #include "GameAPI.h"
+#include "Utilities.h"
+#include "BlockCompression.h"
 #include <vector>
 //#include "EventManager.h"
 
@@ -21,13 +23,19 @@ static std::string	g_savePath;
 //		PluginHeader	plugin[header.numPlugins]
 //			ChunkHeader		chunk[plugin.numChunks]
 //				UInt8			data[chunk.length]
+//
+//	kVersion_Compressed stores everything after the header as:
+//	UInt32			rawLength
+//		BlockHeader		block[]		(each followed by block.packedSize bytes; stored as-is if packedSize == rawSize)
 
 struct Header
 {
 	enum
 	{
-		kSignature =		MACRO_SWAP32('NVSE'),	// endian-swapping so the order matches
-		kVersion =			1,
+		kSignature =			MACRO_SWAP32('NVSE'),	// endian-swapping so the order matches
+		kVersion_Uncompressed =	1,
+		kVersion_Compressed =	2,
+		kVersion =				kVersion_Compressed,
 
 		kVersion_Invalid =	0
 	};
@@ -54,6 +62,12 @@ struct ChunkHeader
 	UInt32	length;
 };
 
+struct BlockHeader
+{
+	UInt32	rawSize;
+	UInt32	packedSize;
+};
+
 // locals
 
 SerializationTask s_serializationTask;
@@ -75,6 +89,10 @@ ChunkHeader		s_chunkHeader = { 0 };
 
 bool			s_preloading = false;		// if true, we are reading co-save *before* savegame begins to load
 
+UInt32			s_compressCoSave = 0;		// nvse_config.ini [SAVE] CompressCoSave
+UInt32			s_asyncCoSave = 0;			// nvse_config.ini [SAVE] AsyncCoSave - write the file on a worker thread
+HANDLE			s_pendingSave = NULL;
+
 // utilities
 
 // change *.fos -> *.nvse
@@ -183,59 +201,260 @@ void InternalSetPreLoadCallback(PluginHandle plugin, NVSESerializationInterface:
 
 #define SERIALIZATION_BUFFER_SIZE 0x400000
 
-alignas(16) static UInt8 s_serializationBuffer[SERIALIZATION_BUFFER_SIZE];
-
-void SerializationTask::Reset()
+static bool WritePackedData(HANDLE saveFile, const UInt8 *data, UInt32 length)
 {
-	bufferPtr = s_serializationBuffer;
-	length = 0;
+	DWORD written;
+	UInt32 rawLength = length - sizeof(Header);
+	if (!WriteFile(saveFile, data, sizeof(Header), &written, NULL) || !WriteFile(saveFile, &rawLength, 4, &written, NULL))
+		return false;
+
+	UInt32 maxPacked = BlockCompression::GetMaxPackedSize(BlockCompression::kBlockSize);
+	UInt8 *packBuffer = (UInt8*)malloc(sizeof(BlockHeader) + maxPacked);
+	if (!packBuffer)
+	{
+		_ERROR("HandleSaveGame: couldn't allocate %08X bytes to compress co-save data", sizeof(BlockHeader) + maxPacked);
+		return false;
+	}
+	BlockHeader *blockHeader = (BlockHeader*)packBuffer;
+	bool result = true;
+	for (UInt32 offset = sizeof(Header); offset < length; offset += blockHeader->rawSize)
+	{
+		blockHeader->rawSize = length - offset;
+		if (blockHeader->rawSize > BlockCompression::kBlockSize)
+			blockHeader->rawSize = BlockCompression::kBlockSize;
+		blockHeader->packedSize = BlockCompression::Pack(data + offset, blockHeader->rawSize, packBuffer + sizeof(BlockHeader), maxPacked);
+		if (blockHeader->packedSize)
+			result = WriteFile(saveFile, packBuffer, sizeof(BlockHeader) + blockHeader->packedSize, &written, NULL);
+		else
+		{
+			blockHeader->packedSize = blockHeader->rawSize;
+			result = WriteFile(saveFile, packBuffer, sizeof(BlockHeader), &written, NULL) &&
+				WriteFile(saveFile, data + offset, blockHeader->rawSize, &written, NULL);
+		}
+		if (!result) break;
+	}
+	free(packBuffer);
+	return result;
 }
 
-bool SerializationTask::Save()
+static bool WriteSaveFile(const char *path, const UInt8 *data, UInt32 length)
 {
-	if (!length) return false;
-
-	HANDLE saveFile = CreateFile(g_savePath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	HANDLE saveFile = CreateFile(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
 	if (saveFile == INVALID_HANDLE_VALUE)
 	{
-		_ERROR("HandleSaveGame: couldn't create save file (%s)", g_savePath.c_str());
+		_ERROR("HandleSaveGame: couldn't create save file (%s)", path);
 		return false;
 	}
 
-	WriteFile(saveFile, s_serializationBuffer, length, &length, NULL);
+	bool result;
+	if (((Header*)data)->formatVersion == Header::kVersion_Compressed)
+		result = WritePackedData(saveFile, data, length);
+	else
+	{
+		DWORD written;
+		result = WriteFile(saveFile, data, length, &written, NULL) && (written == length);
+	}
 	CloseHandle(saveFile);
 
+	if (!result)
+		_ERROR("HandleSaveGame: failed writing save file (%s)", path);
+	return result;
+}
+
+// expands a kVersion_Compressed file in place of the packed data
+static bool UnpackSaveData(SerializationTask &task)
+{
+	const UInt8 *packedData = task.bufferData, *dataEnd = packedData + task.length;
+	const UInt8 *dataPtr = packedData + sizeof(Header) + 4;
+	if (dataPtr > dataEnd)
+	{
+		_ERROR("HandleLoadGame: co-save data is corrupt");
+		task.length = 0;
+		return false;
+	}
+
+	UInt32 rawLength = *(UInt32*)(packedData + sizeof(Header)), outOffset = sizeof(Header);
+	// every block expands to at most kBlockSize, so the stored length can't exceed that per block header
+	UInt32 maxBlocks = (UInt32)(dataEnd - dataPtr) / sizeof(BlockHeader);
+	if (rawLength > ((maxBlocks < (0x40000000 / BlockCompression::kBlockSize)) ? (maxBlocks * BlockCompression::kBlockSize) : 0x40000000))
+	{
+		_ERROR("HandleLoadGame: co-save data is corrupt (unpacked size %08X)", rawLength);
+		task.length = 0;
+		return false;
+	}
+	UInt8 *rawData = (UInt8*)malloc(sizeof(Header) + rawLength);
+	if (!rawData)
+	{
+		_ERROR("HandleLoadGame: couldn't allocate %08X bytes for co-save data", sizeof(Header) + rawLength);
+		task.length = 0;
+		return false;
+	}
+	memcpy(rawData, packedData, sizeof(Header));
+
+	const BlockHeader *blockHeader;
+	while (dataPtr < dataEnd)
+	{
+		blockHeader = (const BlockHeader*)dataPtr;
+		dataPtr += sizeof(BlockHeader);
+		if ((dataPtr > dataEnd) || (blockHeader->packedSize > (UInt32)(dataEnd - dataPtr)) ||
+			(blockHeader->rawSize > (sizeof(Header) + rawLength - outOffset)))
+			break;
+		if (blockHeader->packedSize == blockHeader->rawSize)
+			memcpy(rawData + outOffset, dataPtr, blockHeader->rawSize);
+		else if (BlockCompression::Unpack(dataPtr, blockHeader->packedSize, rawData + outOffset, blockHeader->rawSize) != (SInt32)blockHeader->rawSize)
+			break;
+		dataPtr += blockHeader->packedSize;
+		outOffset += blockHeader->rawSize;
+	}
+
+	free(task.bufferData);
+	task.bufferData = task.bufferPtr = rawData;
+	task.bufferEnd = rawData + sizeof(Header) + rawLength;
+	task.length = outOffset;
+
+	if ((dataPtr != dataEnd) || (outOffset != (sizeof(Header) + rawLength)))
+	{
+		_ERROR("HandleLoadGame: co-save data is corrupt");
+		return false;
+	}
+	return true;
+}
+
+struct PendingSave
+{
+	std::string		path;
+	UInt8			*data;
+	UInt32			length;
+};
+
+static DWORD WINAPI PendingSaveThread(LPVOID param)
+{
+	PendingSave *pending = (PendingSave*)param;
+	WriteSaveFile(pending->path.c_str(), pending->data, pending->length);
+	free(pending->data);
+	delete pending;
+	return 0;
+}
+
+void WaitForPendingSave()
+{
+	if (!s_pendingSave) return;
+	WaitForSingleObject(s_pendingSave, INFINITE);
+	CloseHandle(s_pendingSave);
+	s_pendingSave = NULL;
+}
+
+bool SerializationTask::Reset()
+{
+	if (!bufferData)
+	{
+		bufferData = (UInt8*)malloc(SERIALIZATION_BUFFER_SIZE);
+		if (!bufferData)
+		{
+			bufferPtr = bufferEnd = NULL;
+			length = 0;
+			return false;
+		}
+		bufferEnd = bufferData + SERIALIZATION_BUFFER_SIZE;
+	}
+	bufferPtr = bufferData;
+	length = 0;
 	return true;
 }
 
+void SerializationTask::Grow(UInt32 size)
+{
+	UInt32 offset = GetOffset(), newSize = bufferEnd - bufferData;
+	do
+	{
+		newSize <<= 1;
+	}
+	while (newSize < (offset + size));
+	UInt8 *newData = (UInt8*)realloc(bufferData, newSize);
+	if (!newData) throw std::bad_alloc();
+	bufferData = newData;
+	bufferPtr = newData + offset;
+	bufferEnd = newData + newSize;
+}
+
+bool SerializationTask::Save()
+{
+	if (!length) return false;
+
+	// a previous save may still be writing to the same file
+	WaitForPendingSave();
+
+	if (s_asyncCoSave)
+	{
+		// the buffer is already a complete snapshot; hand it to the writer and start the next save with a fresh one
+		PendingSave *pending = new PendingSave{g_savePath, bufferData, length};
+		s_pendingSave = CreateThread(NULL, 0, PendingSaveThread, pending, 0, NULL);
+		if (s_pendingSave)
+		{
+			bufferData = bufferPtr = bufferEnd = NULL;
+			return true;
+		}
+		delete pending;
+	}
+
+	return WriteSaveFile(g_savePath.c_str(), bufferData, length);
+}
+
 bool SerializationTask::Load()
 {
-	Reset();
+	WaitForPendingSave();
+	if (!Reset())
+	{
+		_ERROR("HandleLoadGame: couldn't allocate the co-save buffer");
+		return false;
+	}
 
 	HANDLE saveFile = CreateFile(g_savePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 	if (saveFile == INVALID_HANDLE_VALUE)
 		return false;
 
-	ReadFile(saveFile, s_serializationBuffer, SERIALIZATION_BUFFER_SIZE, &length, NULL);
+	UInt32 fileSize = GetFileSize(saveFile, NULL);
+	if ((fileSize == INVALID_FILE_SIZE) || (fileSize < sizeof(Header)))
+	{
+		CloseHandle(saveFile);
+		return false;
+	}
+
+	try
+	{
+		Reserve(fileSize);
+	}
+	catch (std::bad_alloc&)
+	{
+		_ERROR("HandleLoadGame: couldn't allocate %08X bytes for co-save file (%s)", fileSize, g_savePath.c_str());
+		CloseHandle(saveFile);
+		return false;
+	}
+	ReadFile(saveFile, bufferData, fileSize, &length, NULL);
 	CloseHandle(saveFile);
 
-	if (length == SERIALIZATION_BUFFER_SIZE)
+	if (length != fileSize)
 	{
-		_ERROR("HandleLoadGame: co-save file exceeds 4MB!");
+		_ERROR("HandleLoadGame: couldn't read co-save file (%s)", g_savePath.c_str());
+		length = 0;
 		return false;
 	}
 
-	return length > 0;
+	Header *header = (Header*)bufferData;
+	if ((header->signature == Header::kSignature) && (header->formatVersion == Header::kVersion_Compressed))
+		return UnpackSaveData(*this);
+
+	return true;
 }
 
 UInt32 SerializationTask::GetOffset() const
 {
-	return (UInt32)(bufferPtr - s_serializationBuffer);
+	return (UInt32)(bufferPtr - bufferData);
 }
 
 void SerializationTask::SetOffset(UInt32 offset)
 {
-	bufferPtr = s_serializationBuffer + offset;
+	bufferPtr = bufferData + offset;
 }
 
 void SerializationTask::Skip(UInt32 size)
@@ -245,12 +464,14 @@ void SerializationTask::Skip(UInt32 size)
 
 void SerializationTask::Write8(UInt8 inData)
 {
+	Reserve(1);
 	*bufferPtr++ = inData;
 	length++;
 }
 
 void SerializationTask::Write16(UInt16 inData)
 {
+	Reserve(2);
 	*(UInt16*)bufferPtr = inData;
 	bufferPtr += 2;
 	length += 2;
@@ -258,6 +479,7 @@ void SerializationTask::Write16(UInt16 inData)
 
 void SerializationTask::Write32(UInt32 inData)
 {
+	Reserve(4);
 	*(UInt32*)bufferPtr = inData;
 	bufferPtr += 4;
 	length += 4;
@@ -265,6 +487,7 @@ void SerializationTask::Write32(UInt32 inData)
 
 void SerializationTask::Write64(const void *inData)
 {
+	Reserve(8);
 	*(UInt64*)bufferPtr = *(UInt64*)inData;
 	bufferPtr += 8;
 	length += 8;
@@ -272,6 +495,7 @@ void SerializationTask::Write64(const void *inData)
 
 void SerializationTask::WriteBuf(const void *inData, UInt32 size)
 {
+	Reserve(size);
 	switch (size)
 	{
 		case 0:
@@ -411,12 +635,14 @@ bool OpenRecord(UInt32 type, UInt32 version)
 		ASSERT(!s_chunkOpen);
 
 		s_pluginHeaderOffset = s_serializationTask.GetOffset();
+		s_serializationTask.Reserve(sizeof(s_pluginHeader));
 		s_serializationTask.Skip(sizeof(s_pluginHeader));
 	}
 
 	FlushWriteChunk();
 
 	s_chunkHeaderOffset = s_serializationTask.GetOffset();
+	s_serializationTask.Reserve(sizeof(s_chunkHeader));
 	s_serializationTask.Skip(sizeof(s_chunkHeader));
 
 	s_pluginHeader.numChunks++;
@@ -554,6 +780,19 @@ void ReadRecord64(void *outData)
 	s_serializationTask.Read64(outData);
 }
 
+const UInt8 * ReadRecordSpan(UInt32 * length)
+{
+	ASSERT(s_chunkOpen);
+
+	// the returned data stays valid until the next co-save is loaded
+	const UInt8 *result = s_serializationTask.bufferPtr;
+	*length = s_chunkHeader.length;
+	s_serializationTask.Skip(s_chunkHeader.length);
+	s_chunkHeader.length = 0;
+
+	return result;
+}
+
 UInt32 PeekRecordData(void * buf, UInt32 length)
 {
 	ASSERT(s_chunkOpen);
@@ -606,13 +845,25 @@ void HandleSaveGame(const char * path)
 
 	_MESSAGE("saving to %s", g_savePath.c_str());
 
-	s_serializationTask.Reset();
+	static bool s_readConfig = false;
+	if (!s_readConfig)
+	{
+		s_readConfig = true;
+		GetNVSEConfigOption_UInt32("SAVE", "CompressCoSave", &s_compressCoSave);
+		GetNVSEConfigOption_UInt32("SAVE", "AsyncCoSave", &s_asyncCoSave);
+	}
+
+	if (!s_serializationTask.Reset())
+	{
+		_ERROR("HandleSaveGame: couldn't allocate the co-save buffer");
+		return;
+	}
 
 	try
 	{
 		// init header
 		s_fileHeader.signature =		Header::kSignature;
-		s_fileHeader.formatVersion =	Header::kVersion;
+		s_fileHeader.formatVersion =	s_compressCoSave ? Header::kVersion_Compressed : Header::kVersion_Uncompressed;
 		s_fileHeader.nvseVersion =		NVSE_VERSION_INTEGER;
 		s_fileHeader.nvseMinorVersion =	NVSE_VERSION_INTEGER_MINOR;
 		s_fileHeader.falloutVersion =	RUNTIME_VERSION;
@@ -742,7 +993,7 @@ void HandleLoadGame(const char * path, NVSESerializationInterface::EventCallback
 				return;
 			}
 			
-			// no older versions to handle
+			// kVersion_Compressed data was already expanded by SerializationTask::Load, nothing else to handle
 
 			// reset flags
 			for (PluginCallbackList::iterator iter = s_pluginCallbacks.begin(); iter != s_pluginCallbacks.end(); ++iter)
@@ -833,6 +1084,7 @@ void HandleDeleteGame(const char * path)
 	GetSaveName(&saveName, path);
 
 	_MESSAGE("deleting %s", savePath.c_str());
+	WaitForPendingSave();
 	PluginManager::Dispatch_Message(0, NVSEMessagingInterface::kMessage_DeleteGame, (void*)savePath.c_str(), strlen(savePath.c_str()), NULL);
 	PluginManager::Dispatch_Message(0, NVSEMessagingInterface::kMessage_DeleteGameName, (void*)saveName.c_str(), strlen(saveName.c_str()), NULL);
 
@@ -850,6 +1102,7 @@ void HandleRenameGame(const char * oldPath, const char * newPath)
 	GetSaveName(&newSaveName, newPath);
 
 	_MESSAGE("renaming %s -> %s", oldSavePath.c_str(), newSavePath.c_str());
+	WaitForPendingSave();
 	PluginManager::Dispatch_Message(0, NVSEMessagingInterface::kMessage_RenameGame, (void*)oldSavePath.c_str(), strlen(oldSavePath.c_str()), NULL);
 	PluginManager::Dispatch_Message(0, NVSEMessagingInterface::kMessage_RenameGameName, (void*)oldSavePath.c_str(), strlen(oldSavePath.c_str()), NULL);
 	PluginManager::Dispatch_Message(0, NVSEMessagingInterface::kMessage_RenameNewGame, (void*)newSavePath.c_str(), strlen(newSavePath.c_str()), NULL);
@@ -9,12 +9,14 @@ namespace Serialization
 
 struct SerializationTask
 {
+	UInt8		*bufferData;
 	UInt8		*bufferPtr;
+	UInt8		*bufferEnd;
 	UInt32		length;
 
-	void Reset();
+	bool Reset();	// false if the buffer couldn't be allocated
 
-	SerializationTask() : bufferPtr(NULL), length(0) {}
+	SerializationTask() : bufferData(NULL), bufferPtr(NULL), bufferEnd(NULL), length(0) {}
 
 	bool Save();
 	bool Load();
@@ -22,6 +24,9 @@ struct SerializationTask
 	UInt32 GetOffset() const;
 	void SetOffset(UInt32 offset);
 
+	void Grow(UInt32 size);
+	void Reserve(UInt32 size) {if ((bufferPtr + size) > bufferEnd) Grow(size);}
+
 	void Skip(UInt32 size);
 
 	void Write8(UInt8 inData);
@@ -71,6 +76,7 @@ void	WriteRecord64(const void *inData);
 
 bool	GetNextRecordInfo(UInt32 * type, UInt32 * version, UInt32 * length);
 UInt32	ReadRecordData(void * buf, UInt32 length);
+const UInt8 *	ReadRecordSpan(UInt32 * length);	// consumes the rest of the current record without copying
 
 UInt8	ReadRecord8();
 UInt16	ReadRecord16();
@@ -94,6 +100,7 @@ void	InternalSetNewGameCallback(PluginHandle plugin, NVSESerializationInterface:
 void	InternalSetPreLoadCallback(PluginHandle plugin, NVSESerializationInterface::EventCallback callback);
 
 const char * GetSavePath(void);
+void	WaitForPendingSave(void);
 extern bool ignoreNextChunk;
 
 }
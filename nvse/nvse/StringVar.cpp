@@ -9,10 +9,136 @@
 #include "GameApi.h"
 #include <set>
 
-StringVar::StringVar(const char* in_data, UInt8 modIndex)
+enum
 {
-	data = in_data;
-	owningModIndex = modIndex;
+	kInternMinLength =	0x10,	// shorter values fit the std::string inline buffer
+	kInternMaxLength =	0x100,
+};
+
+static UnorderedMap<UInt32, InternedString*> s_internTable(0x400);	// StrHashCS -> chain
+static ICriticalSection s_internCS;
+
+static bool InternEnabled()
+{
+	static UInt32 s_internStringVars = 0xFFFFFFFF;
+	if (s_internStringVars == 0xFFFFFFFF)
+	{
+		s_internStringVars = 1;
+		GetNVSEConfigOption_UInt32("MEMORY", "InternStringVars", &s_internStringVars);
+	}
+	return s_internStringVars != 0;
+}
+
+static InternedString* InternAcquire(const char* str, UInt32 length)
+{
+	UInt32 hash = StrHashCS(str);
+	ScopedLock lock(s_internCS);
+	InternedString **pHead;
+	if (s_internTable.Insert(hash, &pHead))
+		*pHead = NULL;
+	for (InternedString *entry = *pHead; entry; entry = entry->next)
+	{
+		if ((entry->length == length) && !memcmp(entry->str, str, length))
+		{
+			entry->refCount++;
+			return entry;
+		}
+	}
+	InternedString *entry = (InternedString*)malloc(offsetof(InternedString, str) + length + 1);
+	entry->next = *pHead;
+	entry->hash = hash;
+	entry->refCount = 1;
+	entry->length = length;
+	memcpy(entry->str, str, length + 1);
+	*pHead = entry;
+	return entry;
+}
+
+static void InternAddRef(InternedString* entry)
+{
+	ScopedLock lock(s_internCS);
+	entry->refCount++;
+}
+
+static void InternRelease(InternedString* entry)
+{
+	ScopedLock lock(s_internCS);
+	if (--entry->refCount)
+		return;
+	InternedString **pHead = s_internTable.GetPtr(entry->hash);
+	if (!pHead) return;
+	for (InternedString **pIter = pHead; *pIter; pIter = &(*pIter)->next)
+	{
+		if (*pIter == entry)
+		{
+			*pIter = entry->next;
+			break;
+		}
+	}
+	if (!*pHead)
+		s_internTable.Erase(entry->hash);
+	free(entry);
+}
+
+StringVar::StringVar(const char* in_data, UInt8 modIndex) : interned(NULL), owningModIndex(modIndex)
+{
+	Set(in_data);
+}
+
+StringVar::StringVar(const StringVar& other) : data(other.data), interned(other.interned), owningModIndex(other.owningModIndex)
+{
+	if (interned)
+		InternAddRef(interned);
+}
+
+StringVar::~StringVar()
+{
+	ReleaseInterned();
+}
+
+StringVar& StringVar::operator=(const StringVar& other)
+{
+	if (this != &other)
+	{
+		if (other.interned)
+			InternAddRef(other.interned);
+		ReleaseInterned();
+		data = other.data;
+		interned = other.interned;
+		owningModIndex = other.owningModIndex;
+	}
+	return *this;
+}
+
+void StringVar::ReleaseInterned()
+{
+	if (interned)
+	{
+		InternRelease(interned);
+		interned = NULL;
+	}
+}
+
+void StringVar::Materialize()
+{
+	if (interned)
+	{
+		data.assign(interned->str, interned->length);
+		ReleaseInterned();
+	}
+}
+
+// Like Materialize, but the interned entry is handed back instead of released: arguments of the modification that
+// follows may point into it. Release it once the modification is done.
+InternedString* StringVar::Unintern()
+{
+	InternedString *oldInterned = interned;
+	if (oldInterned)
+	{
+		data.assign(oldInterned->str, oldInterned->length);
+		interned = NULL;
+	}
+	return oldInterned;
 }
 
 StringVarMap* StringVarMap::GetSingleton()
@@ -22,145 +148,164 @@ StringVarMap* StringVarMap::GetSingleton()
 
 const char* StringVar::GetCString()
 {
-	return data.c_str();
+	return interned ? interned->str : data.c_str();
 }
 
 void StringVar::Set(const char* newString)
 {
-	data = newString;
+	// newString may point into the current value, so release the old value last
+	InternedString *oldInterned = interned;
+	UInt32 length = StrLen(newString);
+	if ((length >= kInternMinLength) && (length <= kInternMaxLength) && InternEnabled())
+	{
+		interned = InternAcquire(newString, length);
+		if (data.capacity() > kInternMinLength)
+			std::string().swap(data);
+		else
+			data.clear();
+	}
+	else
+	{
+		data.assign(newString, length);
+		interned = NULL;
+	}
+	if (oldInterned)
+		InternRelease(oldInterned);
 }
 
 SInt32 StringVar::Compare(char* rhs, bool caseSensitive)
 {
-	return caseSensitive ? strcmp(rhs, data.c_str()) : StrCompare(rhs, data.c_str());
+	return caseSensitive ? strcmp(rhs, GetCString()) : StrCompare(rhs, GetCString());
 }
 
 void StringVar::Insert(const char* subString, UInt32 insertionPos)
 {
+	// subString may point into the current value, std::string handles that for data but not for interned
+	InternedString *oldInterned = Unintern();
 	if (insertionPos < GetLength())
 		data.insert(insertionPos, subString);
 	else if (insertionPos == GetLength())
 		data.append(subString);
+	if (oldInterned)
+		InternRelease(oldInterned);
 }
 
-#pragma warning(disable : 4996)	// disable checked iterator warning for std::transform with char*
-UInt32 StringVar::Find(char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive)
+void StringVar::Append(const char* str)
 {
-	UInt32 pos = -1;
-
-	if (numChars + startPos >= GetLength())
-		numChars = GetLength() - startPos;
-
-	if (startPos < GetLength())
-	{
-		std::string source = data.substr(startPos, numChars);
-		if (!bCaseSensitive)
-		{
-			std::transform(source.begin(), source.end(), source.begin(), tolower);
-			std::transform(subString, subString + strlen(subString), subString, tolower);
-		}
+	InternedString *oldInterned = Unintern();
+	data.append(str);
+	if (oldInterned)
+		InternRelease(oldInterned);
+}
 
-		 //pos = data.substr(startPos, numChars).find(subString);	//returns -1 if not found
-		pos = source.find(subString);
-		if (pos != -1)
-			pos += startPos;
-	}
+UInt32 StringVar::Find(const char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive)
+{
+	UInt32 length = GetLength();
+	if (startPos >= length)
+		return -1;
+	if (numChars > length - startPos)
+		numChars = length - startPos;
 
-	return pos;
+	SubStrFinder finder(subString, StrLen(subString), bCaseSensitive);
+	return finder.Find(GetCString(), startPos + numChars, startPos);
 }
 
-UInt32 StringVar::Count(char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive)
+UInt32 StringVar::Count(const char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive)
 {
-	if (numChars + startPos >= GetLength())
-		numChars = GetLength() - startPos;
-
-	if (startPos >= GetLength())
+	UInt32 length = GetLength();
+	if (startPos >= length)
 		return 0;
+	if (numChars > length - startPos)
+		numChars = length - startPos;
 
-	std::string source = data.substr(startPos, numChars);	//only count occurences beginning before endPos
-	UInt32 subStringLen = strlen(subString);
-	if (!subStringLen)
+	SubStrFinder finder(subString, StrLen(subString), bCaseSensitive);
+	if (!finder.Length())
 		return 0;
 
-	if (!bCaseSensitive)
-	{
-		std::transform(source.begin(), source.end(), source.begin(), tolower);
-		std::transform(subString, subString + strlen(subString), subString, tolower);
-	}
-
-	UInt32 strIdx = 0;
-	UInt32 count = 0;
-	while (strIdx < GetLength() && ((strIdx = source.find(subString, strIdx)) != -1))
-	{
+	const char *src = GetCString();
+	UInt32 endPos = startPos + numChars, count = 0;
+	for (UInt32 pos = startPos; (pos = finder.Find(src, endPos, pos)) != -1; pos += finder.Length())
 		count++;
-		strIdx += subStringLen;
-	}
 
 	return count;
 }
-#pragma warning(default : 4996)
 
 UInt32 StringVar::GetLength()
 {
-	return data.length();
+	return interned ? interned->length : data.length();
 }
 
-UInt32 StringVar::Replace(char* toReplace, char* replaceWith, UInt32 startPos, UInt32 numChars, bool bCaseSensitive, UInt32 numToReplace)
+UInt32 StringVar::Replace(const char* toReplace, const char* replaceWith, UInt32 startPos, UInt32 numChars, bool bCaseSensitive, UInt32 numToReplace)
 {
-	// calc length of substring
-	if (startPos >= GetLength())
+	UInt32 length = GetLength();
+	if (startPos >= length)
 		return 0;
-	else if (numChars + startPos > GetLength())
-		numChars = GetLength() - startPos;
-
-	UInt32 numReplaced = 0;
-	UInt32 replacementLen = strlen(replaceWith);
-	UInt32 toReplaceLen = strlen(toReplace);
+	if (numChars > length - startPos)
+		numChars = length - startPos;
 
-	// create substring
-	std::string srcStr = data.substr(startPos, numChars);
+	SubStrFinder finder(toReplace, StrLen(toReplace), bCaseSensitive);
+	UInt32 toReplaceLen = finder.Length();
+	if (!toReplaceLen || !numToReplace)
+		return 0;
 
-	// remove substring from original string
-	data.erase(startPos, numChars);
+	UInt32 endPos = startPos + numChars;
+	UInt32 pos = finder.Find(GetCString(), endPos, startPos);
+	if (pos == -1)
+		return 0;
 
-	UInt32 strIdx = 0;
-	while (numReplaced < numToReplace)// && (strIdx = srcStr.find(toReplace, strIdx)) != -1)
+	InternedString *oldInterned = Unintern();
+	// the finder and the copy loops read the arguments while data is rewritten, so they can't point into it
+	std::string toReplaceCopy, replaceWithCopy;
+	const char *dataStart = data.data(), *dataEnd = dataStart + data.size();
+	if ((toReplace >= dataStart) && (toReplace <= dataEnd))
 	{
-		if (bCaseSensitive)
-		{
-			strIdx = srcStr.find(toReplace, strIdx);
-			if (strIdx == -1)
-				break;
-		}
-		else
-		{
-			std::string strToReplace = toReplace;
-			std::string::iterator iter = std::search(srcStr.begin() + strIdx, srcStr.end(), strToReplace.begin(), strToReplace.end(), ci_equal);
-			if (iter != srcStr.end())
-				strIdx = iter - srcStr.begin();
-			else
-				break;
-		}
+		toReplaceCopy.assign(toReplace, toReplaceLen);
+		finder = SubStrFinder(toReplaceCopy.c_str(), toReplaceLen, bCaseSensitive);
+	}
+	if ((replaceWith >= dataStart) && (replaceWith <= dataEnd))
+	{
+		replaceWithCopy = replaceWith;
+		replaceWith = replaceWithCopy.c_str();
+	}
 
-		numReplaced++;
-		srcStr.erase(strIdx, toReplaceLen);
-		if (strIdx == srcStr.length())
+	UInt32 replacementLen = StrLen(replaceWith), numReplaced = 0, copied = 0;
+	if (replacementLen <= toReplaceLen)
+	{
+		// result is never longer, so compact in place
+		char *buffer = &data[0];
+		UInt32 written = 0;
+		do
 		{
-			srcStr.append(replaceWith);
-			break;						// reached end of string so all done
+			if (written != copied)
+				memmove(buffer + written, buffer + copied, pos - copied);
+			written += pos - copied;
+			memcpy(buffer + written, replaceWith, replacementLen);
+			written += replacementLen;
+			copied = pos + toReplaceLen;
+			numReplaced++;
 		}
-		else
+		while ((numReplaced < numToReplace) && ((pos = finder.Find(buffer, endPos, copied)) != -1));
+		memmove(buffer + written, buffer + copied, length - copied);
+		data.resize(written + length - copied);
+	}
+	else
+	{
+		const char *src = data.c_str();
+		std::string result;
+		result.reserve(length + replacementLen - toReplaceLen);
+		do
 		{
-			srcStr.insert(strIdx, replaceWith);
-			strIdx += replacementLen;
+			result.append(src + copied, pos - copied);
+			result.append(replaceWith, replacementLen);
+			copied = pos + toReplaceLen;
+			numReplaced++;
 		}
+		while ((numReplaced < numToReplace) && ((pos = finder.Find(src, endPos, copied)) != -1));
+		result.append(src + copied, length - copied);
+		data.swap(result);
 	}
-
-	// paste altered string back into original string
-	if (startPos == GetLength())
-		data.append(srcStr);
-	else
-		data.insert(startPos, srcStr);
+	if (oldInterned)
+		InternRelease(oldInterned);
 
 	return numReplaced;
 }
@@ -171,18 +316,21 @@ void StringVar::Erase(UInt32 startPos, UInt32 numChars)
 		numChars = GetLength() - startPos;
 
 	if (startPos < GetLength())
+	{
+		Materialize();
 		data.erase(startPos, numChars);
+	}
 }
 
 std::string StringVar::SubString(UInt32 startPos, UInt32 numChars)
 {
-	if (numChars + startPos >= GetLength())
-		numChars = GetLength() - startPos;
-
-	if (startPos < GetLength())
-		return data.substr(startPos, numChars);
-	else
+	UInt32 length = GetLength();
+	if (startPos >= length)
 		return "";
+	if (numChars > length - startPos)
+		numChars = length - startPos;
+
+	return std::string(GetCString() + startPos, numChars);
 }
 
 UInt8 StringVar::GetOwningModIndex()
@@ -210,7 +358,7 @@ UInt32 StringVar::GetCharType(char ch)
 char StringVar::At(UInt32 charPos)
 {
 	if (charPos < GetLength())
-		return data[charPos];
+		return GetCString()[charPos];
 	else
 		return -1;
 }
@@ -364,8 +512,7 @@ bool AssignToStringVar(COMMAND_ARGS, const char* newValue) {	// Adds another cal
 
 void StringVarMap::Clean()		// clean up any temporary vars
 {
-	while (!tempIDs.Empty())
-		Delete(tempIDs.LastKey());
+	CleanTemporaries();
 }
 
 namespace PluginAPI
@@ -1,4 +1,5 @@
 #pragma once
+#include <string_view>
 #include "Serialization.h"
 #include "GameAPI.h"
 #include "VarMap.h"
@@ -17,26 +18,49 @@
 //
 // Strings are discarded on load if the mod which created them is no longer present.
 
+// Shared immutable string value, refcounted and owned by the intern table in StringVar.cpp.
+struct InternedString
+{
+	InternedString	*next;		// next entry with the same hash
+	UInt32			hash;
+	UInt32			refCount;
+	UInt32			length;
+	char			str[1];
+};
+
+// Values up to the std::string SSO capacity (15 chars) are kept inline in data. Longer values assigned
+// as a whole (Set) are interned instead, so the many vars holding the same key or editor ID share one
+// allocation; the first in-place modification copies the value back into data.
 class StringVar
 {
-	std::string data;
-	UInt8		owningModIndex;
+	std::string		data;		// unused while interned is set
+	InternedString	*interned;
+	UInt8			owningModIndex;
+
+	void		Materialize();
+	InternedString*	Unintern();
+	void		ReleaseInterned();
 public:
 	StringVar(const char* in_data, UInt8 modIndex);
+	StringVar(const StringVar& other);
+	~StringVar();
+	StringVar& operator=(const StringVar& other);
 
 	void		Set(const char* newString);
 	SInt32		Compare(char* rhs, bool caseSensitive);
 	void		Insert(const char* subString, UInt32 insertionPos);
-	UInt32		Find(char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive = false);	//returns position of substring
-	UInt32		Count(char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive = false);
-	UInt32		Replace(char* toReplace, char* replaceWith, UInt32 startPos, UInt32 numChars, bool bCaseSensitive, UInt32 numToReplace = -1);	//returns num replaced
+	void		Append(const char* str);
+	UInt32		Find(const char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive = false);	//returns position of substring
+	UInt32		Count(const char* subString, UInt32 startPos, UInt32 numChars, bool bCaseSensitive = false);
+	UInt32		Replace(const char* toReplace, const char* replaceWith, UInt32 startPos, UInt32 numChars, bool bCaseSensitive, UInt32 numToReplace = -1);	//returns num replaced
 	void		Erase(UInt32 startPos, UInt32 numChars);
 	std::string	SubString(UInt32 startPos, UInt32 numChars);
 	char		At(UInt32 charPos);
 	static UInt32	GetCharType(char ch);
 
-	std::string String()					{	return data;	}
-	std::string& StringRef() {return data;}
+	std::string_view String()			{	return interned ? std::string_view(interned->str, interned->length) : std::string_view(data);	}
+	// for in-place modification; don't pass it views of this var's own value, use Append/Insert etc. for those
+	std::string& StringRef()			{	Materialize(); return data;	}
 	const char*	GetCString();
 	UInt32		GetLength();
 	UInt8		GetOwningModIndex();	
@@ -4,6 +4,9 @@
 
 // simple template class used to support NVSE custom data types (strings, arrays, etc)
 
+#define VAR_CLEAN_MIN_BATCH		0x40		// always free at least this many temporaries per budgeted clean
+#define VAR_CLEAN_MAX_PENDING	0x10000		// backlog size at which the budget is ignored
+
 struct _VarIDs : Set<UInt32>
 {
 	UInt32 PopFirst()
@@ -26,52 +29,78 @@ protected:
 #else
 	typedef UnorderedMap<UInt32, Var> _VarMap;
 #endif
+	// Per-thread direct-mapped cache of recent lookups. Hits take no lock and touch no shared state.
+	// Any thread deleting vars bumps the map's generation, which makes other threads drop their cached pointers.
 	class VarCache
 	{
-		// if desired this can be replaced with an impl that caches more than one var without changing client code
-		UInt32		varID;
-		Var			* var;
+		enum {kNumSlots = 0x10};
+
+		VarMap		*owner;
+		UInt32		generation;
+		UInt32		varIDs[kNumSlots];
+		Var			*vars[kNumSlots];
 
 	public:
-		VarCache() : varID(0), var(NULL) {}
+		void Reset(VarMap *_owner, UInt32 _generation)
+		{
+			owner = _owner;
+			generation = _generation;
+			memset(varIDs, 0, sizeof(varIDs));
+		}
 
-		~VarCache()
-		{ 
-			Reset(); 
+		void Validate(VarMap *_owner, UInt32 _generation)
+		{
+			if ((owner != _owner) || (generation != _generation))
+				Reset(_owner, _generation);
 		}
 
-		void Insert(UInt32 id, Var* v)
+		// called after this thread bumped the generation itself; earlier entries remain valid only if no other thread did too
+		void Advance(VarMap *_owner, UInt32 newGeneration)
 		{
-			varID = id;
-			var = v;
+			if ((owner == _owner) && ((generation + 1) == newGeneration))
+				generation = newGeneration;
+			else Reset(_owner, newGeneration);
 		}
 
-		// clear all cached vars (only one in current impl)
-		void Reset()
+		void Insert(UInt32 id, Var* v)
 		{
-			varID = 0;
-			var = NULL;
+			UInt32 slot = id & (kNumSlots - 1);
+			varIDs[slot] = id;
+			vars[slot] = v;
 		}
 
 		void Remove(UInt32 id)
 		{
-			if (id == varID)
-			{
-				Reset();
-			}
+			UInt32 slot = id & (kNumSlots - 1);
+			if (varIDs[slot] == id)
+				varIDs[slot] = 0;
 		}
 
-		Var* Get(UInt32 id)
+		Var* Get(UInt32 id) const
 		{
-			return (varID == id) ? var : NULL;
+			UInt32 slot = id & (kNumSlots - 1);
+			return (varIDs[slot] == id) ? vars[slot] : NULL;
 		}
 	};
 
+	static inline thread_local VarCache s_cache;
+
+	VarCache& GetCache()
+	{
+		s_cache.Validate(this, generation);
+		return s_cache;
+	}
+
+	void InvalidateCaches()
+	{
+		s_cache.Advance(this, InterlockedIncrement(&generation));
+	}
+
 	_VarMap				vars;
 	_VarIDs				usedIDs;
 	_VarIDs				tempIDs;		// set of IDs of unreferenced vars, makes for easy cleanup
 	_VarIDs				availableIDs;	// IDs < greatest used ID available as IDs for new vars
-	VarCache			cache;
+	volatile LONG		generation;		// bumped whenever cached Var pointers may have become invalid
 	CRITICAL_SECTION	cs;				// trying to avoid what looks like concurrency issues
 
 
@@ -100,7 +129,7 @@ protected:
 	}
 
 public:
-	VarMap()
+	VarMap() : generation(1)
 	{
 		::InitializeCriticalSection(&cs);
 	}
@@ -114,10 +143,13 @@ public:
 	Var* Get(UInt32 varID)
 	{
 		if (!varID) return NULL;
+		VarCache &cache = GetCache();
 		Var* var = cache.Get(varID);
 		if (!var)
 		{
+			::EnterCriticalSection(&cs);
 			var = vars.GetPtr(varID);
+			::LeaveCriticalSection(&cs);
 			if (var)
 				cache.Insert(varID, var);
 		}
@@ -135,6 +167,9 @@ public:
 		::EnterCriticalSection(&cs);
 		usedIDs.Insert(varID);
 		Var* var = vars.Emplace(varID, std::forward<Args>(args)...);
+#if _DEBUG
+		InvalidateCaches();		// Map may have moved existing vars
+#endif
 		::LeaveCriticalSection(&cs);
 		return var;
 	}
@@ -142,7 +177,14 @@ public:
 	void Delete(UInt32 varID)
 	{
 		::EnterCriticalSection(&cs);
-		cache.Remove(varID);
+		if constexpr (std::is_same_v<Var, ArrayVar>)
+		{
+			// copy-on-write copies still reading this array take their own elements before it goes away
+			if (Var *var = vars.GetPtr(varID))
+				var->DetachShared();
+		}
+		GetCache().Remove(varID);
+		InvalidateCaches();
 		vars.Erase(varID);
 		usedIDs.Erase(varID);
 		tempIDs.Erase(varID);
@@ -158,7 +200,7 @@ public:
 
 	void Reset()
 	{
-		cache.Reset();
+		InvalidateCaches();
 
 		typename _VarMap::Iterator iter;
 		while (true)
@@ -205,4 +247,56 @@ public:
 	{
 		return tempIDs.HasKey(varID);
 	}
+
+	struct CleanStats
+	{
+		UInt32	numFreed;			// by the last CleanTemporaries call
+		UInt32	numPending;			// temporaries still queued after it
+		UInt32	numLive;
+		UInt32	lastPauseMicro;
+		UInt32	maxPauseMicro;
+	};
+
+	const CleanStats& GetCleanStats() const {return cleanStats;}
+
+	// Deletes unreferenced vars, newest IDs first. With a nonzero budget (microseconds) stops once it is spent and leaves
+	// the rest for the next call, unless the backlog has grown past VAR_CLEAN_MAX_PENDING.
+	// Deleting a var may queue more (e.g. arrays nested in a deleted array), so loop until none remain.
+	void CleanTemporaries(UInt32 budgetMicro = 0)
+	{
+		static LARGE_INTEGER s_qpcFreq = {0};
+		if (!s_qpcFreq.QuadPart)
+			QueryPerformanceFrequency(&s_qpcFreq);
+
+		LARGE_INTEGER startTime, curTime;
+		QueryPerformanceCounter(&startTime);
+		if (tempIDs.Size() > VAR_CLEAN_MAX_PENDING)
+			budgetMicro = 0;
+		LONGLONG budgetCounts = (s_qpcFreq.QuadPart * budgetMicro) / 1000000;
+
+		UInt32 numFreed = 0;
+		while (!tempIDs.Empty())
+		{
+			Delete(tempIDs.LastKey());
+			numFreed++;
+			if (budgetMicro && (numFreed >= VAR_CLEAN_MIN_BATCH) && !(numFreed & 0xF))
+			{
+				QueryPerformanceCounter(&curTime);
+				if ((curTime.QuadPart - startTime.QuadPart) >= budgetCounts)
+					break;
+			}
+		}
+		if (!numFreed && !cleanStats.numFreed) return;
+
+		QueryPerformanceCounter(&curTime);
+		cleanStats.numFreed = numFreed;
+		cleanStats.numPending = tempIDs.Size();
+		cleanStats.numLive = vars.Size();
+		cleanStats.lastPauseMicro = (UInt32)(((curTime.QuadPart - startTime.QuadPart) * 1000000) / s_qpcFreq.QuadPart);
+		if (cleanStats.maxPauseMicro < cleanStats.lastPauseMicro)
+			cleanStats.maxPauseMicro = cleanStats.lastPauseMicro;
+	}
+
+protected:
+	CleanStats			cleanStats = {};
 };
\ No newline at end of file
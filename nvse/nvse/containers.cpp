@@ -1,12 +1,196 @@
 #include "nvse/containers.h"
 #include "utility.h"
 
+#include <atomic>
+
 #define MAX_CACHED_BLOCK_SIZE 0x400
 #define MEMORY_POOL_SIZE 0x1000
+#define POOL_THREAD_CACHE 1			// 0 selects the single spin-locked free list pool below
+#define POOL_MAGAZINE_BYTES (MEMORY_POOL_SIZE * 2)	// per thread and size class, half is returned to the depot past this
+
+#if !_DEBUG && POOL_THREAD_CACHE
+
+// Thread-caching pool: each thread keeps a free list per size class and only touches shared state to refill from,
+// or return batches to, a lock-free depot. Blocks are never released back to the CRT.
+// Free block layout: [0] next block, [1] next batch (depot only), [2] batch block count (depot only)
+
+struct PoolThreadCache
+{
+	void	*freeLists[POOL_NUM_CLASSES];
+	UInt32	counts[POOL_NUM_CLASSES];
+	UInt32	hits[POOL_NUM_CLASSES];
+
+	~PoolThreadCache();
+};
+
+struct PoolSharedStats
+{
+	std::atomic<UInt32>	hits;
+	std::atomic<UInt32>	refills;
+	std::atomic<UInt32>	depotReturns;
+	std::atomic<UInt32>	bytesReserved;
+};
+
+alignas(16) static std::atomic<UInt64> s_poolDepots[POOL_NUM_CLASSES];	// low dword: batch, high dword: ABA tag
+static PoolSharedStats s_poolStats[POOL_NUM_CLASSES];
+static thread_local PoolThreadCache s_poolCache;
+
+static void DepotPush(UInt32 classIdx, void **batch)
+{
+	std::atomic<UInt64> &head = s_poolDepots[classIdx];
+	UInt64 oldHead = head.load(std::memory_order_relaxed), newHead;
+	do
+	{
+		batch[1] = (void*)(UInt32)oldHead;
+		newHead = (UInt32)batch | ((oldHead & 0xFFFFFFFF00000000) + 0x100000000);
+	}
+	while (!head.compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed));
+	s_poolStats[classIdx].depotReturns.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void **DepotPop(UInt32 classIdx)
+{
+	std::atomic<UInt64> &head = s_poolDepots[classIdx];
+	UInt64 oldHead = head.load(std::memory_order_acquire), newHead;
+	void **batch;
+	do
+	{
+		batch = (void**)(UInt32)oldHead;
+		if (!batch) return NULL;
+		// batch may already be in use by another thread; the tag makes the exchange fail in that case
+		newHead = (UInt32)batch[1] | ((oldHead & 0xFFFFFFFF00000000) + 0x100000000);
+	}
+	while (!head.compare_exchange_weak(oldHead, newHead, std::memory_order_acquire, std::memory_order_acquire));
+	return batch;
+}
+
+PoolThreadCache::~PoolThreadCache()
+{
+	for (UInt32 classIdx = 1; classIdx < POOL_NUM_CLASSES; classIdx++)
+	{
+		if (!counts[classIdx]) continue;
+		void **batch = (void**)freeLists[classIdx];
+		batch[2] = (void*)counts[classIdx];
+		DepotPush(classIdx, batch);
+		freeLists[classIdx] = NULL;
+		counts[classIdx] = 0;
+	}
+}
+
+__declspec(noinline) static void **PoolRefill(PoolThreadCache &cache, UInt32 classIdx)
+{
+	PoolSharedStats &stats = s_poolStats[classIdx];
+	stats.hits.fetch_add(cache.hits[classIdx], std::memory_order_relaxed);
+	stats.refills.fetch_add(1, std::memory_order_relaxed);
+	cache.hits[classIdx] = 0;
+
+	void **batch = DepotPop(classIdx);
+	if (batch)
+	{
+		cache.counts[classIdx] = (UInt32)batch[2];
+		return batch;
+	}
+
+	UInt32 size = classIdx << 4, numBlocks = MEMORY_POOL_SIZE / size;
+	void *pMemory = _malloc_base(numBlocks * size + 0xF);
+	if (!pMemory)
+		HALT_CODE("PoolRefill: out of memory", numBlocks * size + 0xF);
+	UInt8 *pChunk = (UInt8*)(((UInt32)pMemory + 0xF) & 0xFFFFFFF0);
+	stats.bytesReserved.fetch_add(numBlocks * size, std::memory_order_relaxed);
+	batch = (void**)pChunk;
+	for (UInt32 i = 1; i < numBlocks; i++, pChunk += size)
+		*(void**)pChunk = pChunk + size;
+	*(void**)pChunk = NULL;
+	cache.counts[classIdx] = numBlocks;
+	return batch;
+}
+
+__declspec(noinline) static void PoolFlush(PoolThreadCache &cache, UInt32 classIdx)
+{
+	UInt32 numFlush = cache.counts[classIdx] >> 1;
+	void **batch = (void**)cache.freeLists[classIdx], **pLast = batch;
+	for (UInt32 i = 1; i < numFlush; i++)
+		pLast = (void**)*pLast;
+	cache.freeLists[classIdx] = *pLast;
+	cache.counts[classIdx] -= numFlush;
+	*pLast = NULL;
+	batch[2] = (void*)numFlush;
+	DepotPush(classIdx, batch);
+}
+
+__forceinline UInt32 AlignPoolSize(UInt32 size)
+{
+	return (size <= 0x10) ? 0x10 : ((size + 0xF) & 0xFFFFFFF0);
+}
+
+void* __fastcall Pool_Alloc(UInt32 size)
+{
+	size = AlignPoolSize(size);
+	if (size > MAX_CACHED_BLOCK_SIZE)
+		return _malloc_base(size);
+	UInt32 classIdx = size >> 4;
+	PoolThreadCache &cache = s_poolCache;
+	void **pBlock = (void**)cache.freeLists[classIdx];
+	if (pBlock) cache.hits[classIdx]++;
+	else pBlock = PoolRefill(cache, classIdx);
+	cache.freeLists[classIdx] = *pBlock;
+	cache.counts[classIdx]--;
+	return pBlock;
+}
+
+void __fastcall Pool_Free(void *pBlock, UInt32 size)
+{
+	if (!pBlock) return;
+	size = AlignPoolSize(size);
+	if (size > MAX_CACHED_BLOCK_SIZE)
+	{
+		_free_base(pBlock);
+		return;
+	}
+	UInt32 classIdx = size >> 4;
+	PoolThreadCache &cache = s_poolCache;
+	*(void**)pBlock = cache.freeLists[classIdx];
+	cache.freeLists[classIdx] = pBlock;
+	if ((++cache.counts[classIdx] * size) >= POOL_MAGAZINE_BYTES)
+		PoolFlush(cache, classIdx);
+}
+
+void* __fastcall Pool_Realloc(void *pBlock, UInt32 curSize, UInt32 reqSize)
+{
+	if (!pBlock)
+		return Pool_Alloc(reqSize);
+	if (curSize >= reqSize)
+		return pBlock;
+	if (curSize > MAX_CACHED_BLOCK_SIZE)
+		return _realloc_base(pBlock, reqSize);
+	void *newBlock = Pool_Alloc(reqSize);
+	memcpy(newBlock, pBlock, curSize);
+	Pool_Free(pBlock, curSize);
+	return newBlock;
+}
+
+void* __fastcall Pool_Alloc_Buckets(UInt32 numBuckets)
+{
+	void *data = Pool_Alloc(numBuckets << 2);
+	memset(data, 0, numBuckets << 2);
+	return data;
+}
+
+void Pool_GetStats(PoolClassStats *outStats)
+{
+	for (UInt32 classIdx = 0; classIdx < POOL_NUM_CLASSES; classIdx++, outStats++)
+	{
+		outStats->hits = s_poolStats[classIdx].hits.load(std::memory_order_relaxed);
+		outStats->refills = s_poolStats[classIdx].refills.load(std::memory_order_relaxed);
+		outStats->depotReturns = s_poolStats[classIdx].depotReturns.load(std::memory_order_relaxed);
+		outStats->bytesReserved = s_poolStats[classIdx].bytesReserved.load(std::memory_order_relaxed);
+	}
+}
+
+#elif !_DEBUG
 
 alignas(16) void *s_availableCachedBlocks[(MAX_CACHED_BLOCK_SIZE >> 4) + 1] = {NULL};
 
-#if !_DEBUG
 __declspec(naked) void* __fastcall Pool_Alloc(UInt32 size)
 {
 	__asm
@@ -207,6 +391,13 @@ void* Pool_Alloc_Buckets(UInt32 numBuckets)
 }
 #endif
 
+#if _DEBUG || !POOL_THREAD_CACHE
+void Pool_GetStats(PoolClassStats *outStats)
+{
+	memset(outStats, 0, sizeof(PoolClassStats) * POOL_NUM_CLASSES);
+}
+#endif
+
 __declspec(naked) UInt32 __fastcall AlignBucketCount(UInt32 count)
 {
 	__asm
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <algorithm>
 #include "utility.h"
 
 #define MAP_DEFAULT_ALLOC			8
@@ -21,6 +22,19 @@ void* Pool_Alloc_Buckets(UInt32 numBuckets);
 #endif
 UInt32 __fastcall AlignBucketCount(UInt32 count);
 
+// Per size class (block size >> 4, 16 to 0x400 bytes); only collected by the thread-caching pool
+struct PoolClassStats
+{
+	UInt32	hits;				// allocations served from a thread's cache (counted when that cache refills)
+	UInt32	refills;			// thread cache ran empty
+	UInt32	depotReturns;		// batches handed back to the shared depot
+	UInt32	bytesReserved;		// memory carved into blocks of this class
+};
+
+#define POOL_NUM_CLASSES 0x41
+
+void Pool_GetStats(PoolClassStats *outStats);	// fills POOL_NUM_CLASSES entries
+
 #define POOL_ALLOC(count, type) (type*)Pool_Alloc(count * sizeof(type))
 #define POOL_FREE(block, count, type) Pool_Free(block, count * sizeof(type))
 #define POOL_REALLOC(block, curCount, newCount, type) block = (type*)Pool_Realloc(block, curCount * sizeof(type), newCount * sizeof(type))
@@ -1618,6 +1632,346 @@ public:
 	Iterator Begin() {return Iterator(*this);}
 };
 
+template <typename T_Key> __forceinline UInt32 HashMapKey(T_Key inKey)
+{
+	if constexpr (std::is_same_v<T_Key, char*> || std::is_same_v<T_Key, const char*>)
+		return StrHashCI(inKey);
+	else if constexpr (std::is_floating_point_v<T_Key>)
+	{
+		if (inKey == 0) return 0;	// +0.0 and -0.0 compare equal
+		UInt32 uKey = ((UInt32*)&inKey)[0];
+		if (sizeof(T_Key) > 4)
+			uKey += uKey ^ ((UInt32*)&inKey)[1];
+		return (uKey * 0xD) ^ (uKey >> 0xF);
+	}
+	else return HashKey<T_Key>(inKey);
+}
+
+#define HASHED_MAP_MIN_SLOTS	0x10
+
+// Open-addressing map: entries live in a dense array and are located through a linear-probed slot table
+// holding (entry index + 1). Inserts append and erasures swap-remove, so neither shifts the tail; the entries
+// are sorted by key lazily, only once an ordered iterator is requested.
+template <typename T_Key, typename T_Data> class HashedMap
+{
+	using M_Key = MapKey<T_Key>;
+	using Key_Arg = std::conditional_t<std::is_scalar_v<T_Key>, T_Key, const T_Key&>;
+	using Data_Arg = std::conditional_t<std::is_scalar_v<T_Data>, T_Data, T_Data&>;
+
+	struct Entry
+	{
+		M_Key		key;
+		UInt32		hashVal;
+		T_Data		value;
+
+		void Clear()
+		{
+			key.Clear();
+			value.~T_Data();
+		}
+	};
+
+	Entry		*entries;		// 00
+	UInt32		numEntries;		// 04
+	UInt32		numAlloc;		// 08
+	UInt32		*slots;			// 0C
+	UInt32		numSlots;		// 10
+	UInt8		hashShift;		// 14
+	bool		sorted;			// 15
+
+	UInt32 HomeSlot(UInt32 hashVal) const {return (hashVal * 0x9E3779B1) >> hashShift;}
+
+	UInt32 FindSlot(Key_Arg key, UInt32 hashVal) const
+	{
+		UInt32 mask = numSlots - 1, slotIdx = HomeSlot(hashVal), entryIdx;
+		while (entryIdx = slots[slotIdx])
+		{
+			Entry *pEntry = entries + entryIdx - 1;
+			if ((pEntry->hashVal == hashVal) && !pEntry->key.Compare(key))
+				break;
+			slotIdx = (slotIdx + 1) & mask;
+		}
+		return slotIdx;
+	}
+
+	UInt32 GetEntryIndex(Key_Arg key) const
+	{
+		return numEntries ? slots[FindSlot(key, HashMapKey<T_Key>(key))] : 0;
+	}
+
+	UInt32 LocateSlot(UInt32 entryIdx) const
+	{
+		UInt32 mask = numSlots - 1, slotIdx = HomeSlot(entries[entryIdx].hashVal);
+		entryIdx++;
+		while (slots[slotIdx] != entryIdx)
+			slotIdx = (slotIdx + 1) & mask;
+		return slotIdx;
+	}
+
+	__declspec(noinline) void ResizeTable(UInt32 newCount)
+	{
+		if (slots) Pool_Free(slots, numSlots * sizeof(UInt32));
+		slots = (UInt32*)Pool_Alloc_Buckets(newCount);
+		numSlots = newCount;
+		hashShift = 32;
+		while (newCount >>= 1)
+			hashShift--;
+		UInt32 mask = numSlots - 1, slotIdx;
+		for (UInt32 entryIdx = 0; entryIdx < numEntries; entryIdx++)
+		{
+			slotIdx = HomeSlot(entries[entryIdx].hashVal);
+			while (slots[slotIdx])
+				slotIdx = (slotIdx + 1) & mask;
+			slots[slotIdx] = entryIdx + 1;
+		}
+	}
+
+	// Backward-shift deletion; keeps probe sequences intact without tombstones.
+	void RemoveSlot(UInt32 slotIdx)
+	{
+		UInt32 mask = numSlots - 1, nextIdx = slotIdx, homeIdx, entryIdx;
+		while (entryIdx = slots[nextIdx = (nextIdx + 1) & mask])
+		{
+			homeIdx = HomeSlot(entries[entryIdx - 1].hashVal);
+			if (((nextIdx - homeIdx) & mask) >= ((nextIdx - slotIdx) & mask))
+			{
+				slots[slotIdx] = entryIdx;
+				slotIdx = nextIdx;
+			}
+		}
+		slots[slotIdx] = 0;
+	}
+
+	void RemoveEntry(UInt32 slotIdx)
+	{
+		UInt32 entryIdx = slots[slotIdx] - 1;
+		Entry *pEntry = entries + entryIdx;
+		pEntry->Clear();
+		RemoveSlot(slotIdx);
+		if (entryIdx != --numEntries)
+		{
+			slots[LocateSlot(numEntries)] = entryIdx + 1;
+			memcpy(pEntry, entries + numEntries, sizeof(Entry));
+			sorted = false;
+		}
+	}
+
+	bool InsertKey(Key_Arg key, T_Data **outData)
+	{
+		if (!slots) ResizeTable(HASHED_MAP_MIN_SLOTS);
+		UInt32 hashVal = HashMapKey<T_Key>(key), slotIdx = FindSlot(key, hashVal);
+		if (slots[slotIdx])
+		{
+			*outData = &entries[slots[slotIdx] - 1].value;
+			return false;
+		}
+		if (!entries)
+		{
+			numAlloc = AlignNumAlloc<Entry>(numAlloc);
+			entries = POOL_ALLOC(numAlloc, Entry);
+		}
+		else if (numAlloc <= numEntries)
+		{
+			UInt32 newAlloc = numAlloc << 1;
+			POOL_REALLOC(entries, numAlloc, newAlloc, Entry);
+			numAlloc = newAlloc;
+		}
+		if (((numEntries + 1) << 2) > (numSlots * 3))
+		{
+			ResizeTable(numSlots << 1);
+			slotIdx = FindSlot(key, hashVal);
+		}
+		Entry *pEntry = entries + numEntries;
+		if (sorted && numEntries && (pEntry[-1].key.Compare(key) < 0))
+			sorted = false;
+		slots[slotIdx] = ++numEntries;
+		pEntry->key.Set(key);
+		pEntry->hashVal = hashVal;
+		*outData = &pEntry->value;
+		return true;
+	}
+
+public:
+	HashedMap(UInt32 _alloc = MAP_DEFAULT_ALLOC) : entries(nullptr), numEntries(0), numAlloc(_alloc), slots(nullptr), numSlots(0), hashShift(32), sorted(true) {}
+	~HashedMap()
+	{
+		if (entries)
+		{
+			Clear();
+			POOL_FREE(entries, numAlloc, Entry);
+			entries = nullptr;
+		}
+		if (slots)
+		{
+			Pool_Free(slots, numSlots * sizeof(UInt32));
+			slots = nullptr;
+		}
+	}
+
+	UInt32 Size() const {return numEntries;}
+	bool Empty() const {return !numEntries;}
+	bool IsSorted() const {return sorted;}
+
+	bool Insert(Key_Arg key, T_Data **outData)
+	{
+		if (!InsertKey(key, outData)) return false;
+		new (*outData) T_Data();
+		return true;
+	}
+
+	T_Data& operator[](Key_Arg key)
+	{
+		T_Data *outData;
+		if (InsertKey(key, &outData))
+			new (outData) T_Data();
+		return *outData;
+	}
+
+	template <typename ...Args>
+	T_Data* Emplace(Key_Arg key, Args&& ...args)
+	{
+		T_Data *outData;
+		if (InsertKey(key, &outData))
+			new (outData) T_Data(std::forward<Args>(args)...);
+		return outData;
+	}
+
+	bool HasKey(Key_Arg key) const {return GetEntryIndex(key) != 0;}
+
+	T_Data Get(Key_Arg key)
+	{
+		UInt32 entryIdx = GetEntryIndex(key);
+		return entryIdx ? entries[entryIdx - 1].value : static_cast<T_Data>(NULL);
+	}
+
+	T_Data* GetPtr(Key_Arg key)
+	{
+		UInt32 entryIdx = GetEntryIndex(key);
+		return entryIdx ? &entries[entryIdx - 1].value : nullptr;
+	}
+
+	bool Erase(Key_Arg key)
+	{
+		if (!numEntries) return false;
+		UInt32 slotIdx = FindSlot(key, HashMapKey<T_Key>(key));
+		if (!slots[slotIdx]) return false;
+		RemoveEntry(slotIdx);
+		return true;
+	}
+
+	void Clear()
+	{
+		if (!numEntries) return;
+		Entry *pEntry = entries, *pEnd = entries + numEntries;
+		do
+		{
+			pEntry->Clear();
+			pEntry++;
+		}
+		while (pEntry != pEnd);
+		numEntries = 0;
+		sorted = true;
+		memset(slots, 0, numSlots * sizeof(UInt32));
+	}
+
+	// Restores key order of the entry array and remaps the slot table to the new positions.
+	void Sort()
+	{
+		if (sorted) return;
+		sorted = true;
+		if (numEntries < 2) return;
+		UInt32 *order = POOL_ALLOC(numEntries * 2, UInt32), *newIndex = order + numEntries, idx;
+		for (idx = 0; idx < numEntries; idx++)
+			order[idx] = idx;
+		Entry *oldEntries = entries;
+		std::sort(order, order + numEntries, [oldEntries](UInt32 lIdx, UInt32 rIdx)
+		{
+			return oldEntries[lIdx].key.Compare(oldEntries[rIdx].key.Get()) > 0;
+		});
+		entries = POOL_ALLOC(numAlloc, Entry);
+		for (idx = 0; idx < numEntries; idx++)
+		{
+			memcpy(entries + idx, oldEntries + order[idx], sizeof(Entry));
+			newIndex[order[idx]] = idx + 1;
+		}
+		for (idx = 0; idx < numSlots; idx++)
+			if (slots[idx]) slots[idx] = newIndex[slots[idx] - 1];
+		POOL_FREE(oldEntries, numAlloc, Entry);
+		POOL_FREE(order, numEntries * 2, UInt32);
+	}
+
+	// Ordered iteration; constructing an iterator sorts the entries if needed.
+	class Iterator
+	{
+		friend HashedMap;
+
+		HashedMap	*table;
+		Entry		*pEntry;
+		UInt32		index;
+
+	public:
+		Key_Arg Key() const {return pEntry->key.Get();}
+		Data_Arg Get() const {return pEntry->value;}
+		Data_Arg operator*() const {return pEntry->value;}
+		Data_Arg operator->() const {return pEntry->value;}
+		Data_Arg operator()() const {return pEntry->value;}
+		bool End() const {return index >= table->numEntries;}
+		explicit operator bool() const {return index < table->numEntries;}
+		HashedMap* Table() const {return table;}
+
+		Iterator() : table(nullptr), pEntry(nullptr), index(0) {}
+
+		void Init(HashedMap &source)
+		{
+			source.Sort();
+			table = &source;
+			pEntry = table->entries;
+			index = 0;
+		}
+
+		void Last(HashedMap &source)
+		{
+			source.Sort();
+			table = &source;
+			index = table->numEntries;
+			if (index)
+			{
+				index--;
+				pEntry = table->entries + index;
+			}
+		}
+
+		void operator++()
+		{
+			pEntry++;
+			index++;
+		}
+		void operator--()
+		{
+			pEntry--;
+			index--;
+		}
+
+		void Find(HashedMap &source, Key_Arg key)
+		{
+			source.Sort();
+			table = &source;
+			pEntry = table->entries;
+			if (index = table->GetEntryIndex(key))
+				pEntry += --index;
+			else index = -1;
+		}
+
+		UInt32 Index() const {return index;}
+
+		Iterator(HashedMap &source) {Init(source);}
+		Iterator(HashedMap &source, Key_Arg key) {Find(source, key);}
+	};
+
+	Iterator Begin() {return Iterator(*this);}
+	Iterator Find(Key_Arg key) {return Iterator(*this, key);}
+};
+
 template <typename T_Data> class Vector
 {
 	using Data_Arg = std::conditional_t<std::is_scalar_v<T_Data>, T_Data, T_Data&>;
@@ -107,6 +107,20 @@ void NVSE_Initialize(void)
 
 		gLog.SetLogLevel((IDebugLog::LogLevel)logLevel);
 
+		UInt32 asyncLog = 0, logQueueSize = 0x400, dropOnOverflow = 0, rateLimit = 0;
+		if (GetNVSEConfigOption_UInt32("LOGGING", "RateLimitPerSecond", &rateLimit) && rateLimit)
+		{
+			gLog.SetRateLimit(IDebugLog::kLevel_Message, rateLimit);
+			gLog.SetRateLimit(IDebugLog::kLevel_VerboseMessage, rateLimit);
+			gLog.SetRateLimit(IDebugLog::kLevel_DebugMessage, rateLimit);
+		}
+		if (GetNVSEConfigOption_UInt32("LOGGING", "AsyncLog", &asyncLog) && asyncLog)
+		{
+			GetNVSEConfigOption_UInt32("LOGGING", "AsyncLogQueueSize", &logQueueSize);
+			GetNVSEConfigOption_UInt32("LOGGING", "AsyncLogDropOnOverflow", &dropOnOverflow);
+			gLog.StartAsync(logQueueSize, dropOnOverflow ? IDebugLog::kOverflow_Drop : IDebugLog::kOverflow_Block);
+		}
+
 		MersenneTwister::init_genrand(GetTickCount());
 		CommandTable::Init();
 
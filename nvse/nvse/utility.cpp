@@ -283,6 +283,72 @@ char* __fastcall SubStrCI(const char *srcStr, const char *subStr)
 	return NULL;
 }
 
+SubStrFinder::SubStrFinder(const char *_pattern, UInt32 _patternLen, bool _caseSensitive) :
+	pattern((const UInt8*)_pattern), patternLen(_patternLen), caseSensitive(_caseSensitive)
+{
+	if (patternLen < 2) return;
+	for (UInt32 i = 0; i < 0x100; i++)
+		skip[i] = patternLen;
+	UInt32 last = patternLen - 1;
+	if (caseSensitive)
+	{
+		for (UInt32 i = 0; i < last; i++)
+			skip[pattern[i]] = last - i;
+	}
+	else
+	{
+		for (UInt32 i = 0; i < last; i++)
+			skip[kCaseConverter[pattern[i]]] = last - i;
+	}
+}
+
+UInt32 SubStrFinder::Find(const char *src, UInt32 srcLen, UInt32 start) const
+{
+	if ((start > srcLen) || (patternLen > (srcLen - start)))
+		return -1;
+	if (!patternLen)
+		return start;
+	const UInt8 *data = (const UInt8*)src;
+	UInt32 last = patternLen - 1, endPos = srcLen - last, index;
+	if (caseSensitive)
+	{
+		if (!last)
+		{
+			const void *found = memchr(data + start, *pattern, srcLen - start);
+			return found ? (const UInt8*)found - data : -1;
+		}
+		UInt8 lastChr = pattern[last];
+		for (UInt32 pos = start; pos < endPos; pos += skip[data[pos + last]])
+		{
+			if (data[pos + last] != lastChr)
+				continue;
+			for (index = 0; (index < last) && (data[pos + index] == pattern[index]); index++);
+			if (index == last)
+				return pos;
+		}
+	}
+	else
+	{
+		UInt8 lastChr = kCaseConverter[pattern[last]];
+		if (!last)
+		{
+			for (UInt32 pos = start; pos < srcLen; pos++)
+				if (kCaseConverter[data[pos]] == lastChr)
+					return pos;
+			return -1;
+		}
+		for (UInt32 pos = start; pos < endPos; pos += skip[kCaseConverter[data[pos + last]]])
+		{
+			if (kCaseConverter[data[pos + last]] != lastChr)
+				continue;
+			for (index = 0; (index < last) && (kCaseConverter[data[pos + index]] == kCaseConverter[pattern[index]]); index++);
+			if (index == last)
+				return pos;
+		}
+	}
+	return -1;
+}
+
 char* __fastcall SlashPos(const char *str)
 {
 	if (!str) return NULL;
@@ -91,6 +91,23 @@ char* __fastcall SubStrCI(const char *srcStr, const char *subStr);
 
 char* __fastcall SlashPos(const char *str);
 
+//	Horspool substring search over a length-bounded range, with an optional case-folded skip table.
+//	Does not allocate and does not modify either string; lives on the stack for the duration of a search.
+class SubStrFinder
+{
+	const UInt8		*pattern;
+	UInt32			patternLen;
+	bool			caseSensitive;
+	UInt32			skip[0x100];
+
+public:
+	SubStrFinder(const char *_pattern, UInt32 _patternLen, bool _caseSensitive);
+
+	//	Offset of the first occurrence lying entirely within [start, srcLen), or -1.
+	UInt32 Find(const char *src, UInt32 srcLen, UInt32 start) const;
+	UInt32 Length() const {return patternLen;}
+};
+
 char* __fastcall CopyString(const char* key);
 
 char* __fastcall IntToStr(char *str, int num);
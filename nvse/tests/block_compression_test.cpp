@@ -0,0 +1,200 @@
+#include "BlockCompression.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int g_failures = 0;
+
+	void Check(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			g_failures++;
+		}
+	}
+
+	typedef std::vector<UInt8> Bytes;
+
+	// runs of repeated and random bytes plus repeated words, roughly what co-save records look like
+	Bytes MakeData(std::mt19937 &rng, UInt32 size, UInt32 randomPercent)
+	{
+		static const char *kWords[] = {"array", "string", "ref", "0x0001F4A2", "script", "var", "\0\0\0\0", "health"};
+		Bytes data;
+		data.reserve(size);
+		while (data.size() < size)
+		{
+			UInt32 kind = rng() % 100;
+			if (kind < randomPercent)
+				data.push_back((UInt8)rng());
+			else if (kind % 2)
+				data.insert(data.end(), rng() % 40 + 1, (UInt8)rng());
+			else
+			{
+				const char *word = kWords[rng() % 8];
+				data.insert(data.end(), word, word + (word[0] ? strlen(word) : 4));
+			}
+		}
+		data.resize(size);
+		return data;
+	}
+
+	Bytes Pack(const Bytes &raw)
+	{
+		Bytes packed(BlockCompression::GetMaxPackedSize(raw.size()));
+		packed.resize(BlockCompression::Pack(raw.data(), raw.size(), packed.data(), packed.size()));
+		return packed;
+	}
+
+	// dest is sized exactly, so the sanitizers catch any write past it
+	SInt32 Unpack(const Bytes &packed, UInt32 rawSize, Bytes &out)
+	{
+		out.assign(rawSize, 0);
+		return BlockCompression::Unpack(packed.data(), packed.size(), out.data(), rawSize);
+	}
+
+	void TestRoundTrip()
+	{
+		std::mt19937 rng(1);
+		Bytes out;
+		UInt32 numPacked = 0;
+		for (UInt32 i = 0; i < 20000; i++)
+		{
+			// every size up to 100, then mostly small blocks with a full size one now and then
+			UInt32 size = (i < 100) ? i : rng() % ((i % 16) ? 0x1000 : BlockCompression::kBlockSize) + 1;
+			Bytes raw = MakeData(rng, size, rng() % 101);
+			Bytes packed = Pack(raw);
+			// 0 means the block is stored raw
+			if (packed.empty())
+				continue;
+			numPacked++;
+			if (packed.size() >= raw.size() || Unpack(packed, size, out) != (SInt32)size || out != raw)
+			{
+				Check(false, "round trip");
+				return;
+			}
+		}
+		Check(numPacked > 10000, "compressible blocks packed");
+
+		Bytes zeros(BlockCompression::kBlockSize, 0);
+		Bytes packed = Pack(zeros);
+		Check(!packed.empty() && packed.size() < 0x200, "zero block packs small");
+		Check(Unpack(packed, zeros.size(), out) == (SInt32)zeros.size() && out == zeros, "zero block round trip");
+
+		std::mt19937 noiseRng(2);
+		Bytes noise = MakeData(noiseRng, BlockCompression::kBlockSize, 100);
+		Check(Pack(noise).empty(), "incompressible block left raw");
+	}
+
+	void TestSmallDestination()
+	{
+		std::mt19937 rng(3);
+		Bytes raw = MakeData(rng, 0x4000, 20);
+		Bytes packed = Pack(raw);
+		Check(!packed.empty(), "small destination setup");
+		for (UInt32 size = 0; size < packed.size(); size += 7)
+		{
+			Bytes dest(size);
+			if (BlockCompression::Pack(raw.data(), raw.size(), dest.data(), size))
+			{
+				Check(false, "pack fails when the destination is too small");
+				break;
+			}
+		}
+		Bytes out;
+		Check(Unpack(packed, raw.size() - 1, out) == -1, "unpack fails when the destination is too small");
+	}
+
+	void TestTruncated()
+	{
+		std::mt19937 rng(4);
+		Bytes out;
+		for (UInt32 i = 0; i < 50; i++)
+		{
+			Bytes raw = MakeData(rng, rng() % 0x2000 + 0x100, 10);
+			Bytes packed = Pack(raw);
+			out.resize(raw.size());
+			for (UInt32 length = 0; length < packed.size(); length++)
+			{
+				if (BlockCompression::Unpack(packed.data(), length, out.data(), out.size()) == (SInt32)raw.size())
+				{
+					Check(false, "truncated block rejected");
+					return;
+				}
+			}
+		}
+	}
+
+	void TestCorrupt()
+	{
+		std::mt19937 rng(5);
+		Bytes out;
+		for (UInt32 i = 0; i < 20000; i++)
+		{
+			Bytes raw = MakeData(rng, rng() % 0x1000 + 0x40, 10);
+			Bytes packed = Pack(raw);
+			if (packed.empty())
+				continue;
+			for (UInt32 flips = rng() % 4 + 1; flips; flips--)
+				packed[rng() % packed.size()] ^= (UInt8)(rng() % 0xFF + 1);
+			// only has to stay in bounds; a flip inside literals still decodes
+			SInt32 result = Unpack(packed, raw.size(), out);
+			if (result < -1 || result > (SInt32)raw.size())
+			{
+				Check(false, "corrupt block result in range");
+				return;
+			}
+		}
+	}
+
+	void ReportThroughput()
+	{
+		const UInt32 kNumBlocks = 0x400;	// 64MB
+		std::mt19937 rng(6);
+		std::vector<Bytes> blocks, packedBlocks;
+		for (UInt32 i = 0; i < 0x40; i++)
+			blocks.push_back(MakeData(rng, BlockCompression::kBlockSize, 5));
+		UInt64 rawTotal = (UInt64)kNumBlocks * BlockCompression::kBlockSize, packedTotal = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (UInt32 i = 0; i < kNumBlocks; i++)
+		{
+			Bytes packed = Pack(blocks[i % blocks.size()]);
+			packedTotal += packed.size();
+			if (i < blocks.size())
+				packedBlocks.push_back(packed);
+		}
+		double packSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		Bytes out(BlockCompression::kBlockSize);
+		bool ok = true;
+		start = std::chrono::steady_clock::now();
+		for (UInt32 i = 0; i < kNumBlocks; i++)
+		{
+			const Bytes &packed = packedBlocks[i % packedBlocks.size()];
+			ok &= BlockCompression::Unpack(packed.data(), packed.size(), out.data(), out.size()) == (SInt32)out.size();
+		}
+		double unpackSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		Check(ok, "throughput blocks round trip");
+
+		double megabytes = rawTotal / (1024.0 * 1024.0);
+		printf("pack %.0f MB/s, unpack %.0f MB/s, ratio %.2f\n", megabytes / packSeconds, megabytes / unpackSeconds,
+			(double)packedTotal / rawTotal);
+	}
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestSmallDestination();
+	TestTruncated();
+	TestCorrupt();
+	ReportThroughput();
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	return g_failures ? 1 : 0;
+}
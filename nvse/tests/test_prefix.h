@@ -0,0 +1,20 @@
+#pragma once
+
+// Stands in for nvse/prefix.h, which the Windows projects force-include, when the OS-independent parts of xNVSE are
+// built on their own
+
+#include <cstdint>
+#include <cstring>
+
+typedef std::uint8_t	UInt8;
+typedef std::uint16_t	UInt16;
+typedef std::uint32_t	UInt32;
+typedef std::uint64_t	UInt64;
+typedef std::int8_t		SInt8;
+typedef std::int16_t	SInt16;
+typedef std::int32_t	SInt32;
+typedef std::int64_t	SInt64;
+
+#ifndef _MSC_VER
+#define __forceinline	inline __attribute__((always_inline))
+#endif
@@ -3,22 +3,193 @@
 #include "blend_fixes.h"
 #include "blend_smoothing.h"
 #include "hooks.h"
+#include "lru_cache.h"
 #include "SafeWrite.h"
 #include "sequence_extradata.h"
 #include "utility.h"
 
+#include <mutex>
+
 namespace
 {
+    // Bones of an AnimData's skeleton by name. Names are NiFixedStrings, so looking one up is a pointer hash instead of
+    // a recursive scene graph search. Bones hold no reference: each one keeps the child indices leading to it from nBip01
+    // and is only trusted if walking them from the live root still reaches it, so a detached node is never touched. A
+    // lookup that misses or finds a stale bone falls back to GetObjectByName, which picks up nodes attached later (weapon
+    // models). Rebuilt when nBip01 changes and dropped with the AnimData; the generation tells sequences whose bone
+    // bindings were made against an older skeleton. Everything here is guarded by g_skeletonIndexMutex.
+    struct SkeletonBone
+    {
+        NiAVObject* node = nullptr;
+        std::vector<UInt16> path;
+    };
+
+    struct SkeletonIndex
+    {
+        NiNode* root = nullptr;
+        std::unordered_map<const char*, SkeletonBone> bones;
+        UInt32 generation = 0;
+    };
+
+    std::unordered_map<AnimData*, SkeletonIndex> g_skeletonIndexes;
+    UInt32 g_skeletonIndexGeneration = 0;
+    std::mutex g_skeletonIndexMutex;
+
+    // first match in the same order GetObjectByName searches in
+    void IndexBones(SkeletonIndex& index, NiAVObject* node, std::vector<UInt16>& path)
+    {
+        if (node->m_pcName.data)
+            index.bones.try_emplace(node->m_pcName.data, SkeletonBone{node, path});
+        auto* niNode = node->GetAsNiNode();
+        if (!niNode)
+            return;
+        for (UInt16 i = 0; i < niNode->m_children.m_usSize; ++i)
+        {
+            if (auto* child = niNode->m_children.m_pBase[i])
+            {
+                path.push_back(i);
+                IndexBones(index, child, path);
+                path.pop_back();
+            }
+        }
+    }
+
+    SkeletonIndex* GetSkeletonIndex(AnimData* animData)
+    {
+        auto* root = animData->nBip01;
+        if (!root)
+            return nullptr;
+        auto& index = g_skeletonIndexes[animData];
+        if (index.root != root)
+        {
+            index.root = root;
+            index.bones.clear();
+            std::vector<UInt16> path;
+            IndexBones(index, root, path);
+            index.generation = ++g_skeletonIndexGeneration;
+        }
+        return &index;
+    }
+
+    NiAVObject* ResolveBone(const SkeletonIndex& index, const char* name, const SkeletonBone& bone)
+    {
+        NiAVObject* node = index.root;
+        for (const auto childIndex : bone.path)
+        {
+            auto* parent = node->GetAsNiNode();
+            if (!parent || childIndex >= parent->m_children.m_usSize)
+                return nullptr;
+            node = parent->m_children.m_pBase[childIndex];
+            if (!node)
+                return nullptr;
+        }
+        return node == bone.node && node->m_pcName.data == name ? node : nullptr;
+    }
+
+    NiAVObject* FindBone(SkeletonIndex& index, const char* name)
+    {
+        const auto iter = index.bones.find(name);
+        if (iter != index.bones.end())
+        {
+            if (auto* node = ResolveBone(index, name, iter->second))
+                return node;
+        }
+        auto* node = BSUtilities::GetObjectByName(index.root, name);
+        if (!node)
+        {
+            if (iter != index.bones.end())
+            {
+                index.bones.erase(iter);
+                index.generation = ++g_skeletonIndexGeneration;
+            }
+            return nullptr;
+        }
+        SkeletonBone bone{node, {}};
+        for (NiAVObject* child = node; child != index.root; child = child->m_pkParent)
+        {
+            auto* parent = child->m_pkParent;
+            if (!parent)
+                return node;
+            UInt16 childIndex = 0;
+            while (childIndex < parent->m_children.m_usSize && parent->m_children.m_pBase[childIndex] != child)
+                ++childIndex;
+            bone.path.push_back(childIndex);
+        }
+        ra::reverse(bone.path);
+        index.bones.insert_or_assign(name, std::move(bone));
+        index.generation = ++g_skeletonIndexGeneration;
+        return node;
+    }
+
+    // Transform of each controlled block of a reference sequence at a time point, valid where the block's bone exists
+    struct ReferencePose
+    {
+        std::vector<NiQuatTransform> transforms;
+        std::vector<bool> valid;
+    };
+
+    // Reference poses are the same for every actor playing the same reference sequence on the same skeleton layout, so
+    // they're shared across actors. Each actor has its own copy of a sequence, so they're keyed by sequence name. Least
+    // recently used poses are evicted past 256; callers keep theirs alive through the shared_ptr.
+    struct ReferencePoseKey
+    {
+        // holds a reference, so the name can't be freed and its address reused by another sequence's name while cached
+        NiFixedString sequenceName;
+        float timePoint;
+        UInt32 layoutHash;
+
+        bool operator==(const ReferencePoseKey& other) const = default;
+    };
+
+    struct ReferencePoseKeyHash
+    {
+        std::size_t operator()(const ReferencePoseKey& key) const
+        {
+            return std::hash<const char*>()(key.sequenceName.data) ^ std::hash<float>()(key.timePoint) << 1 ^ key.layoutHash;
+        }
+    };
+
+    LruCache<ReferencePoseKey, std::shared_ptr<const ReferencePose>, ReferencePoseKeyHash, 256> g_referencePoseCache;
+
+    std::shared_ptr<const ReferencePose> GetReferencePose(NiControllerSequence* referencePoseSequence, std::span<NiAVObject* const> bones, float timePoint)
+    {
+        // which of the sequence's bones the skeleton has, the bones themselves don't matter to keyframe interpolators
+        UInt32 layoutHash = 0x811C9DC5;
+        for (auto* bone : bones)
+            layoutHash = (layoutHash ^ (bone != nullptr)) * 0x01000193;
+        const ReferencePoseKey key{ referencePoseSequence->m_kName, timePoint, layoutHash };
+        if (auto pose = g_referencePoseCache.Get(key))
+            return pose;
+
+        const auto refBlocks = referencePoseSequence->GetControlledBlocks();
+        auto pose = std::make_shared<ReferencePose>();
+        pose->transforms.resize(refBlocks.size());
+        pose->valid.resize(refBlocks.size());
+        for (size_t i = 0; i < refBlocks.size(); ++i)
+        {
+            NiInterpolator* refInterp = refBlocks[i].m_spInterpolator;
+            if (!refInterp || !bones[i])
+                continue;
+            const float fOldTime = refInterp->m_fLastTime;
+            pose->valid[i] = refInterp->Update(timePoint, bones[i], pose->transforms[i]);
+            refInterp->m_fLastTime = fOldTime;
+        }
+        g_referencePoseCache.Add(key, pose);
+        return pose;
+    }
+
     void AddReferencePoseTransforms(AnimData* animData, NiControllerSequence* additiveSequence,
                                        NiControllerSequence* referencePoseSequence, float timePoint, bool ignorePriorities)
     {
         const auto refBlocks = referencePoseSequence->GetControlledBlocks();
 
-        NiNode* node = animData->nBip01;
-        if (!node)
+        const auto bones = AdditiveManager::GetBoneBindings(animData, referencePoseSequence);
+        if (bones.size() != refBlocks.size())
             return;
-        for (auto& refBlock : refBlocks)
+        const auto referencePose = GetReferencePose(referencePoseSequence, bones, timePoint);
+        for (size_t i = 0; i < refBlocks.size(); ++i)
         {
+            auto& refBlock = refBlocks[i];
             const auto& idTag = refBlock.GetIDTag(referencePoseSequence);
             NiInterpolator* refInterp = refBlock.m_spInterpolator;
             const auto* additiveBlock = additiveSequence->GetControlledBlock(idTag.m_kAVObjectName);
@@ -32,16 +203,12 @@ namespace
             if (!target)
                 continue;
         
-            NiAVObject* targetNode = node->GetObjectByName(idTag.m_kAVObjectName);
-            if (!targetNode)
+            if (!bones[i])
                 continue;
 
-            const float fOldTime = refInterp->m_fLastTime;
-            NiQuatTransform refTransform;
-            const bool bSuccess = refInterp->Update(timePoint, targetNode, refTransform);
-            refInterp->m_fLastTime = fOldTime;
-            if (bSuccess)
+            if (referencePose->valid[i])
             {
+                const auto& refTransform = referencePose->transforms[i];
                 auto* extraData = kBlendInterpolatorExtraData::Obtain(target);
                 DebugAssert(extraData);
                 auto& extraInterpItem = extraData->ObtainItem(additiveInterp);
@@ -176,6 +343,55 @@ void AdditiveManager::SetAdditiveInterpWeightMult(NiObjectNET* target, NiInterpo
     }
 }
 
+NiAVObject* AdditiveManager::GetBone(AnimData* animData, const NiFixedString& name)
+{
+    std::unique_lock lock(g_skeletonIndexMutex);
+    auto* index = GetSkeletonIndex(animData);
+    if (!index || !name.data)
+        return nullptr;
+    return FindBone(*index, name.data);
+}
+
+std::vector<NiAVObject*> AdditiveManager::GetBoneBindings(AnimData* animData, NiControllerSequence* sequence)
+{
+    std::unique_lock lock(g_skeletonIndexMutex);
+    auto* index = GetSkeletonIndex(animData);
+    if (!index)
+        return {};
+    auto* sequenceExtraData = SequenceExtraDatas::Get(sequence);
+    auto& bindings = sequenceExtraData->boneBindings;
+    const auto idTags = sequence->GetIDTags();
+    bool stale = sequenceExtraData->boneBindingsGeneration != index->generation || bindings.size() != idTags.size();
+    for (size_t i = 0; i < bindings.size() && !stale; ++i)
+    {
+        if (!bindings[i])
+            continue;
+        const char* name = idTags[i].m_kAVObjectName.data;
+        const auto iter = index->bones.find(name);
+        stale = iter == index->bones.end() || ResolveBone(*index, name, iter->second) != bindings[i];
+    }
+    if (stale)
+    {
+        bindings.clear();
+        for (const auto& idTag : idTags)
+            bindings.push_back(idTag.m_kAVObjectName.data ? FindBone(*index, idTag.m_kAVObjectName.data) : nullptr);
+        sequenceExtraData->boneBindingsGeneration = index->generation;
+    }
+    return bindings;
+}
+
+void AdditiveManager::EraseAnimData(AnimData* animData)
+{
+    std::unique_lock lock(g_skeletonIndexMutex);
+    g_skeletonIndexes.erase(animData);
+}
+
+void AdditiveManager::ClearReferencePoseCache()
+{
+    const auto stats = g_referencePoseCache.Clear();
+    DebugPrint(FormatString("Reference pose cache: %u hits, %u misses, %u evictions", stats.hits, stats.misses, stats.evictions));
+}
+
 void NiBlendTransformInterpolator::ApplyAdditiveTransforms(
     float fTime, NiObjectNET* pkInterpTarget, NiQuatTransform& kValue) const
 {
@@ -2,6 +2,9 @@
 #include "GameProcess.h"
 #include "NiNodes.h"
 
+#include <span>
+#include <vector>
+
 inline const char* sAdditiveSequenceMetadata = "AdditiveSequenceMetadata";
 
 struct AdditiveSequenceMetadata
@@ -26,4 +29,12 @@ namespace AdditiveManager
     void WriteHooks();
     bool IsAdditiveInterpolator(NiObjectNET* target, NiInterpolator* interpolator);
     void MarkInterpolatorsAsAdditive(const NiControllerSequence* additiveSequence);
+
+    // bone of animData's skeleton by name, searching the scene graph only when the index misses or is stale
+    NiAVObject* GetBone(AnimData* animData, const NiFixedString& name);
+    // bone of animData's skeleton targeted by each of the sequence's controlled blocks, nullptr where there is none; a
+    // copy, since the cached bindings may be rebuilt by another caller once the index lock is released
+    std::vector<NiAVObject*> GetBoneBindings(AnimData* animData, NiControllerSequence* sequence);
+    void EraseAnimData(AnimData* animData);
+    void ClearReferencePoseCache();
 }
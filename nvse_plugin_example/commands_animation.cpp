@@ -28,7 +28,9 @@
 #include "NiNodes.h"
 #include "NiObjects.h"
 #include "NiTypes.h"
+#include "profiler.h"
 #include "ScriptUtils.h"
+#include "script_cache.h"
 #include "string_view_util.h"
 
 std::span<AnimGroupInfo> g_animGroupInfos = { reinterpret_cast<AnimGroupInfo*>(0x11977D8), 245 };
@@ -120,6 +122,19 @@ BSAnimGroupSequence* GetAnimationByPath(const char* path)
 
 // intentional const char*, anim paths are pooled and their pointers remain consistent throughout lifetime
 std::unordered_map<std::pair<const char*, AnimData*>, BSAnimationContext, pair_hash, pair_equal> g_cachedAnimMap;
+OwnerIndex<AnimData*, const char*> g_cachedAnimsByAnimData;
+
+// interned by pooled path, handles stay put since the map is node based
+std::unordered_map<const char*, AnimPathHandle> g_animPathHandles;
+
+struct AnimPathArg
+{
+	std::string path; // as extracted, before lowercasing
+	AnimPathHandle* handle = nullptr;
+};
+
+// keyed by the address of the command's arguments in the script data and the path's index among them
+std::unordered_map<std::pair<const UInt8*, UInt32>, AnimPathArg, pair_hash, pair_equal> g_animPathArgs;
 
 
 #if _DEBUG
@@ -139,22 +154,54 @@ std::shared_mutex g_loadCustomAnimationMutex;
 void HandleOnAnimDataDelete(AnimData* animData)
 {
 	const auto actorId = animData->actor ? animData->actor->refID : 0;
-	if (actorId)
 	{
 		std::unique_lock lock(g_animTimeMutex);
-		std::erase_if(g_timeTrackedAnims, _L(auto& p, p.second->actorId == actorId));
-		std::erase_if(g_burstFireQueue, _L(auto& p, p.actorId == actorId));
+		if (actorId)
+		{
+			for (auto* anim : g_timeTrackedAnimsByActor.Take(actorId))
+			{
+				if (const auto iter = g_timeTrackedAnims.find(anim); iter != g_timeTrackedAnims.end() && iter->second->actorId == actorId)
+					g_timeTrackedAnims.erase(iter);
+			}
+		}
+		// burst fire entries keep a pointer to their AnimData, so they go with it even without an actor
+		g_burstFireQueue.RemoveAnimData(animData);
 	}
 	
 	{
 		std::unique_lock lock(g_pollConditionMutex);
-		std::erase_if(g_timeTrackedGroups, _L(auto & iter, iter.second->animData == animData));
+		g_timeTrackedGroups.EraseAnimData(animData);
 	}
 	
 	{
 		std::unique_lock lock(g_loadCustomAnimationMutex);
-		std::erase_if(g_cachedAnimMap, _L(auto& p, p.first.second == animData));
+		for (const char* path : g_cachedAnimsByAnimData.Take(animData))
+			g_cachedAnimMap.erase(std::make_pair(path, animData));
+	}
+
+	g_queuedReplaceAnims.RemoveAnimData(animData);
+	AdditiveManager::EraseAnimData(animData);
+
+#if _DEBUG
+	// anything left behind was added without going through its owner index
+	{
+		std::unique_lock lock(g_animTimeMutex);
+		if (actorId && ra::any_of(g_timeTrackedAnims, _L(auto& p, p.second->actorId == actorId)))
+			DebugPrint(FormatString("HandleOnAnimDataDelete: leaked time tracked anims for actor %X", actorId));
+		if (g_burstFireQueue.ContainsAnimData(animData))
+			DebugPrint(FormatString("HandleOnAnimDataDelete: leaked burst fire entries for anim data %X", reinterpret_cast<UInt32>(animData)));
 	}
+	{
+		std::unique_lock lock(g_pollConditionMutex);
+		if (g_timeTrackedGroups.ContainsAnimData(animData))
+			DebugPrint(FormatString("HandleOnAnimDataDelete: leaked time tracked groups for anim data %X", reinterpret_cast<UInt32>(animData)));
+	}
+	{
+		std::unique_lock lock(g_loadCustomAnimationMutex);
+		if (ra::any_of(g_cachedAnimMap, _L(auto& p, p.first.second == animData)))
+			DebugPrint(FormatString("HandleOnAnimDataDelete: leaked cached anims for anim data %X", reinterpret_cast<UInt32>(animData)));
+	}
+#endif
 }
 
 thread_local GameAnimMap* s_customMap = nullptr;
@@ -197,6 +244,8 @@ std::optional<BSAnimationContext> LoadCustomAnimation(std::string_view path, Ani
 					if (base && ((anim = base->GetSequenceByIndex(-1))))
 					{
 						auto iter = g_cachedAnimMap.emplace(key, BSAnimationContext(anim, base));
+						if (iter.second)
+							g_cachedAnimsByAnimData.Add(animData, key.first);
 						return iter.first->second;
 					}
 					ERROR_LOG("Map returned null anim " + std::string(path));
@@ -270,17 +319,203 @@ AnimPath* HandleAimUpDownRandomness(UInt32 animGroupId, std::vector<AnimPath*>&
 	return nullptr;
 }
 
-std::list<BurstFireData> g_burstFireQueue;
+BurstFireQueue g_burstFireQueue;
+
+void BurstFireQueue::Add(AnimData* animData, BSAnimGroupSequence* anim, bool firstPerson, std::span<const float> hitKeyTimes, std::span<const float> ejectKeyTimes)
+{
+	if (keyTimes.size() > numLiveKeyTimes * 2 + 0x100)
+		CompactKeyTimes();
+	auto& entry = entries.emplace_back();
+	entry.anim = anim;
+	entry.animData = animData;
+	entry.actorId = animData->actor->refID;
+	entry.keysStart = keyTimes.size();
+	entry.numHitKeys = hitKeyTimes.size();
+	entry.numEjectKeys = ejectKeyTimes.size();
+	entry.firstPerson = firstPerson;
+	keyTimes.insert(keyTimes.end(), hitKeyTimes.begin(), hitKeyTimes.end());
+	keyTimes.insert(keyTimes.end(), ejectKeyTimes.begin(), ejectKeyTimes.end());
+	numLiveKeyTimes += hitKeyTimes.size() + ejectKeyTimes.size();
+	UpdateNextDueTime(entry);
+	slotsByAnimData.Add(animData, entries.size() - 1);
+}
+
+void BurstFireQueue::Remove(UInt32 slot)
+{
+	auto& entry = entries[slot];
+	slotsByAnimData.Remove(entry.animData, slot);
+	numLiveKeyTimes -= entry.numHitKeys + entry.numEjectKeys;
+	const UInt32 lastSlot = entries.size() - 1;
+	if (slot != lastSlot)
+	{
+		auto& last = entries[lastSlot];
+		slotsByAnimData.Remove(last.animData, lastSlot);
+		slotsByAnimData.Add(last.animData, slot);
+		entry = last;
+	}
+	entries.pop_back();
+	if (entries.empty())
+		keyTimes.clear();
+}
+
+void BurstFireQueue::RemoveAnimData(AnimData* animData)
+{
+	// highest slot first, so swapping in the last entry never moves one of the slots still to be removed
+	auto slots = slotsByAnimData.Take(animData);
+	std::ranges::sort(slots, std::greater());
+	for (const auto slot : slots)
+		Remove(slot);
+}
+
+bool BurstFireQueue::ContainsAnimData(AnimData* animData) const
+{
+	return ra::any_of(entries, _L(const Entry& entry, entry.animData == animData));
+}
+
+void BurstFireQueue::UpdateNextDueTime(Entry& entry) const
+{
+	entry.nextDueTime = FLT_MAX;
+	if (entry.HasHitKey())
+		entry.nextDueTime = GetHitKeyTime(entry);
+	if (entry.HasEjectKey())
+		entry.nextDueTime = std::min(entry.nextDueTime, GetEjectKeyTime(entry));
+}
+
+void BurstFireQueue::CompactKeyTimes()
+{
+	std::vector<float> compacted;
+	compacted.reserve(numLiveKeyTimes);
+	for (auto& entry : entries)
+	{
+		const auto begin = keyTimes.begin() + entry.keysStart;
+		entry.keysStart = compacted.size();
+		compacted.insert(compacted.end(), begin, begin + entry.numHitKeys + entry.numEjectKeys);
+	}
+	keyTimes = std::move(compacted);
+}
 
 TimeTrackedAnimsMap g_timeTrackedAnims;
-TimeTrackedGroupsMap g_timeTrackedGroups;
+OwnerIndex<UInt32, BSAnimGroupSequence*> g_timeTrackedAnimsByActor;
+TimeTrackedGroups g_timeTrackedGroups;
+
+SavedAnimsTime& TimeTrackedGroups::GetOrCreate(SavedAnims* savedAnims, AnimData* animData, UInt32 pollInterval)
+{
+	const auto key = std::make_pair(savedAnims, animData);
+	if (const auto iter = lookup.find(key); iter != lookup.end())
+		return entries[iter->second].time;
+	UInt32 slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		slot = entries.size();
+		entries.emplace_back();
+	}
+	auto& entry = entries[slot];
+	entry.savedAnims = savedAnims;
+	entry.time = SavedAnimsTime();
+	entry.time.animData = animData;
+	entry.generation = nextGeneration++;
+	entry.pollInterval = std::max(pollInterval, 1u);
+	// never due in the frame it was added in, and spread out by slot so entries with the same interval don't all land on one frame
+	entry.nextPollFrame = frame + 1 + slot % entry.pollInterval;
+	lookup.emplace(key, slot);
+	keysByAnimData.Add(animData, savedAnims);
+	return entry.time;
+}
+
+void TimeTrackedGroups::EraseSlot(UInt32 slot)
+{
+	auto& entry = entries[slot];
+	auto* animData = entry.time.animData;
+	lookup.erase(std::make_pair(entry.savedAnims, animData));
+	entry.savedAnims = nullptr;
+	freeSlots.push_back(slot);
+	++stats.erased;
+}
+
+void TimeTrackedGroups::Erase(UInt32 slot, UInt32 generation)
+{
+	// the entry may have been erased or replaced by a script or anim call since the caller read it
+	if (slot >= entries.size())
+		return;
+	auto& entry = entries[slot];
+	if (!entry.savedAnims || entry.generation != generation)
+		return;
+	keysByAnimData.Remove(entry.time.animData, entry.savedAnims);
+	EraseSlot(slot);
+}
+
+void TimeTrackedGroups::EraseAnimData(AnimData* animData)
+{
+	for (auto* savedAnims : keysByAnimData.Take(animData))
+	{
+		if (const auto iter = lookup.find(std::make_pair(savedAnims, animData)); iter != lookup.end())
+			EraseSlot(iter->second);
+	}
+}
+
+bool TimeTrackedGroups::ContainsAnimData(AnimData* animData) const
+{
+	return ra::any_of(entries, _L(const Entry& entry, entry.savedAnims && entry.time.animData == animData));
+}
+
+void TimeTrackedGroups::Clear()
+{
+	entries.clear();
+	freeSlots.clear();
+	lookup.clear();
+	keysByAnimData.Clear();
+	scanStart = scanEnd = scanned = nextScanStart = 0;
+}
+
+void TimeTrackedGroups::BeginFrame(UInt32 frameBudget)
+{
+	++frame;
+	budget = frameBudget;
+	scanEnd = entries.size();
+	scanStart = nextScanStart < scanEnd ? nextScanStart : 0;
+	nextScanStart = 0;
+	scanned = 0;
+	stats = FrameStats();
+	stats.tracked = lookup.size();
+}
+
+bool TimeTrackedGroups::NextDue(UInt32& slot)
+{
+	while (scanned < scanEnd)
+	{
+		const UInt32 cur = (scanStart + scanned++) % scanEnd;
+		auto& entry = entries[cur];
+		if (!entry.savedAnims || entry.nextPollFrame > frame)
+			continue;
+		if (budget && stats.polled >= budget)
+		{
+			// stays due, next frame starts with the first one left over
+			if (!stats.deferred++)
+				nextScanStart = cur;
+			continue;
+		}
+		entry.nextPollFrame = frame + entry.pollInterval;
+		++stats.polled;
+		slot = cur;
+		return true;
+	}
+	return false;
+}
 
 void EraseTimeTrackedAnim(BSAnimGroupSequence* anim)
 {
 	std::unique_lock lock(g_animTimeMutex);
 	std::erase_if(g_timeTrackedAnims, [anim](const auto& p)
 	{
-		return p.second->anim == anim;
+		if (p.second->anim != anim)
+			return false;
+		g_timeTrackedAnimsByActor.Remove(p.second->actorId, p.first);
+		return true;
 	});
 }
 
@@ -323,6 +558,8 @@ AnimTime* HandleExtraOperations(AnimData* animData, BSAnimGroupSequence* anim, b
 		if (!animTimePtr)
 		{
 			const auto iter = g_timeTrackedAnims.emplace(anim, std::make_unique<AnimTime>(actor, anim));
+			if (iter.second)
+				g_timeTrackedAnimsByActor.Add(actor->refID, anim);
 			animTimePtr = iter.first->second.get();
 		}
 		return *animTimePtr;
@@ -374,9 +611,9 @@ AnimTime* HandleExtraOperations(AnimData* animData, BSAnimGroupSequence* anim, b
 
 	if (anim->animGroup && anim->animGroup->IsAttack() && hasKey({"burstFire"}))
 	{
-		std::vector<NiTextKey*> hitKeys;
-		std::vector<NiTextKey*> ejectKeys;
-		const auto parseForKeys = [&](const char* keyName, std::vector<NiTextKey*>& keys)
+		std::vector<float> hitKeys;
+		std::vector<float> ejectKeys;
+		const auto parseForKeys = [&](const char* keyName, std::vector<float>& keys)
 		{
 			bool skippedFirst = false;
 			for (auto& key : textKeys)
@@ -389,7 +626,7 @@ AnimTime* HandleExtraOperations(AnimData* animData, BSAnimGroupSequence* anim, b
 						skippedFirst = true;
 						continue;
 					}
-					keys.push_back(&key);
+					keys.push_back(key.m_fTime);
 				}
 			}
 		};
@@ -397,7 +634,7 @@ AnimTime* HandleExtraOperations(AnimData* animData, BSAnimGroupSequence* anim, b
 		parseForKeys("eject", ejectKeys);
 		if (!hitKeys.empty() || !ejectKeys.empty())
 		{
-			g_burstFireQueue.emplace_back(animData == g_thePlayer->firstPersonAnimData, anim, 0, std::move(hitKeys), 0.0,false, -FLT_MAX, animData->actor->refID, std::move(ejectKeys), 0, false);
+			g_burstFireQueue.Add(animData, anim, animData == g_thePlayer->firstPersonAnimData, hitKeys, ejectKeys);
 		}
 	}
 	const auto hasRespectEndKey = hasKey({"respectEndKey", "respectTextKeys"});
@@ -495,12 +732,18 @@ AnimTime* HandleExtraOperations(AnimData* animData, BSAnimGroupSequence* anim, b
 					return false;
 				auto formattedLine = ReplaceAll(line, "%R", "\r\n");
 				formattedLine = ReplaceAll(formattedLine, "%r", "\r\n");
+				if ((result = CompiledScriptCache::Create(CompiledScriptCache::Kind::ScriptLine, line)))
+				{
+					cached = result;
+					return true;
+				}
 				result = Script::CompileFromText(formattedLine, "ScriptLineKey");
 				if (!result)
 				{
 					ERROR_LOG("Failed to compile script in scriptLine key: " + line + " for anim " + std::string(anim->m_kName.CStr()));
 					return false;
 				}
+				CompiledScriptCache::Add(CompiledScriptCache::Kind::ScriptLine, line, result);
 				cached = result;
 				return true;
 			});
@@ -582,13 +825,13 @@ std::optional<AnimationResult> PickAnimation(AnimOverrideStruct& overrides, UInt
 			const auto initAnimTime = [&](SavedAnims* savedAnims)
 			{
 				std::unique_lock lock(g_pollConditionMutex);
-				auto& animTime = g_timeTrackedGroups[std::make_pair(savedAnims, animData)];
-				if (!animTime)
-					animTime = std::make_unique<SavedAnimsTime>();
-				animTime->conditionScript = *savedAnims->conditionScript;
-				animTime->groupId = groupId;
-				animTime->actorId = animData->actor->refID;
-				animTime->animData = animData;
+				// the player's anims are what the user sees and reacts to, so they're evaluated every frame
+				const auto pollInterval = animData->actor == g_thePlayer ? 1 : g_pluginSettings.pollConditionInterval;
+				auto& animTime = g_timeTrackedGroups.GetOrCreate(savedAnims, animData, pollInterval);
+				animTime.conditionScript = *savedAnims->conditionScript;
+				animTime.groupId = groupId;
+				animTime.actorId = animData->actor->refID;
+				animTime.animData = animData;
 			};
 			if (!ctx->loaded)
 				ctx->Load();
@@ -1310,7 +1553,7 @@ void LogScript(Script* scriptObj, TESForm* form, const std::string& funcName)
 		LOG("\tGLOBALLY on any form");
 }
 
-ScopedList<char> GetDirectoryAnimPaths(std::string_view path)
+FileFinder::FileList GetDirectoryAnimPaths(std::string_view path)
 {
 	sv::stack_string<0x400> resultPath = path;
 	if (resultPath.ends_with('\\'))
@@ -1318,7 +1561,7 @@ ScopedList<char> GetDirectoryAnimPaths(std::string_view path)
 	
 	const sv::stack_string<0x400> searchPath = { R"(data\meshes\%s\*.kf)", resultPath.c_str() };
 	const sv::stack_string<0x400> renamePath = { R"(%s\*.kf)", resultPath.c_str() };
-	return FileFinder::FindFiles(searchPath.c_str(), renamePath.c_str(), ARCHIVE_TYPE_MESHES);
+	return FileFinder::FindFilesCached(searchPath.c_str(), renamePath.c_str(), ARCHIVE_TYPE_MESHES);
 }
 
 template <typename F>
@@ -1331,13 +1574,13 @@ bool OverrideAnimsFromScript(char* path, const F& overrideAnim)
 	// directory
 	const auto animPaths = GetDirectoryAnimPaths(pathStr.data());
 
-	if (animPaths.Empty())
+	if (animPaths->empty())
 		return false;
 
 	size_t numAnims = 0;
-	for (const auto* animPath : animPaths)
+	for (const auto& animPath : *animPaths)
 	{
-		numAnims += overrideAnim(animPath);
+		numAnims += overrideAnim(animPath.c_str());
 	}
 	return numAnims != 0;
 }
@@ -1589,8 +1832,14 @@ bool Cmd_kNVSEReset_Execute(COMMAND_ARGS)
 	g_scriptCallExecutions.clear();
 	g_scriptLineExecutions.clear();
 	g_cachedAnimMap.clear();
+	g_cachedAnimsByAnimData.Clear();
 	g_timeTrackedAnims.clear();
-	g_timeTrackedGroups.clear();
+	g_timeTrackedAnimsByActor.Clear();
+	g_timeTrackedGroups.Clear();
+	g_animPathArgs.clear();
+	g_animPathHandles.clear();
+	AdditiveManager::ClearReferencePoseCache();
+	FileFinder::ClearCache();
 	// HandleGarbageCollection();
 	LoadFileAnimPaths();
 
@@ -1742,6 +1991,28 @@ std::vector<std::string_view> FindCustomAnimations(AnimData* animData, const UIn
 
 std::unordered_set<BaseProcess*> g_allowedNextAnims;
 
+constexpr auto ANIM_PATH_ARGS_MAX = 0x2000;
+
+AnimPathHandle& GetAnimPathHandle(const void* scriptData, UInt32 argsOffset, UInt32 argIndex, const char* path)
+{
+	const auto key = std::make_pair(static_cast<const UInt8*>(scriptData) + argsOffset, argIndex);
+	if (const auto iter = g_animPathArgs.find(key); iter != g_animPathArgs.end() && iter->second.path == path)
+		return *iter->second.handle;
+	// string variables and arguments evaluated into a temporary buffer don't repeat, don't let them pile up; handles
+	// are only referenced from args and for the duration of a command, so they go too
+	if (g_animPathArgs.size() >= ANIM_PATH_ARGS_MAX || g_animPathHandles.size() >= ANIM_PATH_ARGS_MAX)
+	{
+		g_animPathArgs.clear();
+		g_animPathHandles.clear();
+	}
+	const auto pooledPath = AddStringToPool(ToLower(path));
+	auto& handle = g_animPathHandles.try_emplace(pooledPath.data(), pooledPath).first->second;
+	auto& arg = g_animPathArgs[key];
+	arg.path = path;
+	arg.handle = &handle;
+	return handle;
+}
+
 BSAnimGroupSequence* FindActiveAnimationByPath(AnimData* animData, const char* path)
 {
 	if (!animData->controllerManager)
@@ -1751,7 +2022,34 @@ BSAnimGroupSequence* FindActiveAnimationByPath(AnimData* animData, const char* p
 	return nullptr;
 }
 
-BSAnimGroupSequence* FindActiveAnimationForActor(Actor* actor, const char* path, POVSwitchState pov = POVSwitchState::NotSet)
+BSAnimGroupSequence* FindActiveAnimationByPath(AnimData* animData, AnimPathHandle& path)
+{
+	auto* manager = animData->controllerManager;
+	if (!manager)
+		return nullptr;
+	// the manager holds a reference to everything in its sequences, so lastAnim is alive if its slot still has it
+	auto& sequences = manager->sequences;
+	if (path.lastAnim && path.lastManager == manager && path.lastIndex < sequences.m_usSize
+		&& sequences.m_pBase[path.lastIndex].data == path.lastAnim && path.lastAnim->m_kName.data
+		&& !_stricmp(path.lastAnim->m_kName.data, path.path.data()))
+		return path.lastAnim;
+	auto* anim = FindActiveAnimationByPath(animData, path.path.data());
+	path.lastAnim = nullptr;
+	for (UInt32 i = 0; anim && i < sequences.m_usSize; ++i)
+	{
+		if (sequences.m_pBase[i].data == anim)
+		{
+			path.lastManager = manager;
+			path.lastAnim = anim;
+			path.lastIndex = i;
+			break;
+		}
+	}
+	return anim;
+}
+
+template <typename Path>
+BSAnimGroupSequence* FindActiveAnimationForActor(Actor* actor, Path&& path, POVSwitchState pov = POVSwitchState::NotSet)
 {
 	AnimData* animData = nullptr;
 	if ((actor == g_thePlayer && g_thePlayer->IsFirstPerson() && pov == POVSwitchState::NotSet) || (pov == POVSwitchState::POV1st && actor == g_thePlayer))
@@ -1805,6 +2103,18 @@ BSAnimGroupSequence* FindOrLoadAnim(AnimData* animData, const char* path)
 	return nullptr;
 }
 
+BSAnimGroupSequence* FindOrLoadAnim(AnimData* animData, AnimPathHandle& path)
+{
+	if (!animData || !animData->controllerManager)
+		return nullptr;
+	if (auto* anim = FindActiveAnimationByPath(animData, path))
+		return anim;
+	const auto& ctx = LoadCustomAnimation(path.path, animData);
+	if (ctx)
+		return ctx->anim;
+	return nullptr;
+}
+
 BSAnimGroupSequence* FindOrLoadAnim(TESObjectREFR* thisObj, const char* path)
 {
 	if (!thisObj)
@@ -1819,7 +2129,8 @@ BSAnimGroupSequence* FindOrLoadAnim(TESObjectREFR* thisObj, const char* path)
 	return FindActiveAnimationForRef(thisObj, path);
 }
 
-BSAnimGroupSequence* FindOrLoadAnim(Actor* actor, const char* path, bool firstPerson)
+template <typename Path>
+BSAnimGroupSequence* FindOrLoadAnim(Actor* actor, Path&& path, bool firstPerson)
 {
 	if (!actor->baseProcess)
 		return nullptr;
@@ -2182,13 +2493,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		char path[0x400];
 		path[0] = 0;
 		float time;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &path, &time))
 			return true;
-		SetLowercase(path);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor || !actor->baseProcess)
 			return true;
-		auto* anim = FindActiveAnimationForActor(actor, path);
+		auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, path));
 		if (!anim)
 			return true;
 		AnimData* animData;
@@ -2218,13 +2529,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		*result = 0;
 		char path[0x400];
 		path[0] = 0;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &path))
 			return true;
-		SetLowercase(path);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
-		const auto* anim = FindActiveAnimationForActor(actor, path);
+		const auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, path));
 		if (!anim)
 			return true;
 		if (anim->m_eState != kAnimState_Inactive && anim->m_eState != kAnimState_EaseOut) 
@@ -2253,9 +2564,9 @@ void CreateCommands(NVSECommandBuilder& builder)
 		float easeInTime = INVALID_TIME;
 		char timeSyncSequence[0x400];
 		timeSyncSequence[0] = 0;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &sequencePath, &firstPerson, &priority, &startOver, &weight, &easeInTime, &timeSyncSequence))
 			return true;
-		SetLowercase(sequencePath);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
@@ -2263,7 +2574,7 @@ void CreateCommands(NVSECommandBuilder& builder)
 		{
 			firstPerson = IsPlayerInFirstPerson(actor);
 		}
-		auto* anim = FindOrLoadAnim(actor, sequencePath, firstPerson);
+		auto* anim = FindOrLoadAnim(actor, GetAnimPathHandle(scriptData, argsOffset, 0, sequencePath), firstPerson);
 		if (!anim)
 			return true;
 		if (weight == INVALID_TIME)
@@ -2278,8 +2589,7 @@ void CreateCommands(NVSECommandBuilder& builder)
 		BSAnimGroupSequence* timeSyncSeq = nullptr;
 		if (timeSyncSequence[0])
 		{
-			SetLowercase(timeSyncSequence);
-			timeSyncSeq = FindOrLoadAnim(actor, timeSyncSequence, firstPerson);
+			timeSyncSeq = FindOrLoadAnim(actor, GetAnimPathHandle(scriptData, argsOffset, 6, timeSyncSequence), firstPerson);
 			if (!timeSyncSeq)
 				return true;
 		}
@@ -2313,13 +2623,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		char sequencePath[0x400];
 		sequencePath[0] = 0;
 		float easeOutTime = INVALID_TIME;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &sequencePath, &easeOutTime))
 			return true;
-		SetLowercase(sequencePath);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
-		auto* anim = FindActiveAnimationForActor(actor, sequencePath);
+		auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, sequencePath));
 		if (!anim)
 			return true;
 		if (easeOutTime == INVALID_TIME)
@@ -2532,19 +2842,20 @@ void CreateCommands(NVSECommandBuilder& builder)
 		char sequencePath[0x400];
 		sequencePath[0] = 0;
 		float weight = 0.0f;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &sequencePath, &weight) || !thisObj)
 			return true;
-		SetLowercase(sequencePath);
+		auto& pathHandle = GetAnimPathHandle(scriptData, argsOffset, 0, sequencePath);
 		BSAnimGroupSequence* anim;
 		if (thisObj)
 		{
 			auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 			if (!actor)
 				return true;
-			anim = FindActiveAnimationForActor(actor, sequencePath);
+			anim = FindActiveAnimationForActor(actor, pathHandle);
 		}
 		else
-			anim = GetAnimationByPath(sequencePath);
+			anim = GetAnimationByPath(pathHandle.path.data());
 		if (!anim)
 			return true;
 		anim->m_fSeqWeight = weight;
@@ -2595,13 +2906,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		*result = 0;
 		char path[0x400];
 		path[0] = 0;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &path))
 			return true;
-		SetLowercase(path);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
-		auto* anim = FindActiveAnimationForActor(actor, path);
+		auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, path));
 		if (!anim)
 			return true;
 		*result = anim->m_fLastScaledTime;
@@ -2650,8 +2961,7 @@ void CreateCommands(NVSECommandBuilder& builder)
 		auto* anim = FindOrLoadAnim(animData, animPath);
 		if (!anim || !anim->animGroup)
 			return true;
-		auto& queue = g_queuedReplaceAnims[std::make_pair(anim->animGroup->groupID, animData)];
-		queue.push_back(anim);
+		g_queuedReplaceAnims.Push(animData, anim->animGroup->groupID, anim);
 		*result = 1;
 		return true;
 	});
@@ -2678,11 +2988,7 @@ void CreateCommands(NVSECommandBuilder& builder)
 				return true;
 			animData = g_thePlayer->firstPersonAnimData;
 		}
-		if (const auto iter = g_queuedReplaceAnims.find(std::make_pair(anim->animGroup->groupID, animData)); iter != g_queuedReplaceAnims.end())
-		{
-			const auto& queue = iter->second;
-			*result = ra::find(queue, anim) != queue.end();
-		}
+		*result = g_queuedReplaceAnims.Contains(animData, anim->animGroup->groupID, anim);
 		return true;
 	});
 
@@ -2872,13 +3178,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		*result = -1;
 		char animPath[0x400];
 		animPath[0] = 0;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &animPath))
 			return true;
-		SetLowercase(animPath);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
-		auto* anim = FindActiveAnimationForActor(actor, animPath);
+		auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, animPath));
 		if (!anim || !anim->animGroup)
 			return true;
 		*result = anim->animGroup->groupID >> 8 & 0xF;
@@ -2892,13 +3198,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 		char textKey[0x400];
 		animPath[0] = 0;
 		textKey[0] = 0;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &animPath, &textKey))
 			return true;
-		SetLowercase(animPath);
 		auto* actor = DYNAMIC_CAST(thisObj, TESObjectREFR, Actor);
 		if (!actor)
 			return true;
-		auto* anim = FindActiveAnimationForActor(actor, animPath);
+		auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, animPath));
 		if (!anim || !anim->animGroup)
 			return true;
 		NiTextKeyExtraData* textKeyData = anim->m_spTextKeys;
@@ -2979,27 +3285,27 @@ void CreateCommands(NVSECommandBuilder& builder)
 	{
 		*result = 0;
 		sv::stack_string<0x400> animPath;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &animPath))
 			return true;
-		SetLowercase(animPath.data_);
-		animPath.calculate_size();
 		auto* actor = DYNAMIC_CAST(thisObj, TESForm, Actor);
 		if (!actor)
 			return true;
-		const auto* anim = FindActiveAnimationForActor(actor, animPath.c_str());
+		const auto* anim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, animPath.data_));
 		if (!anim)
 			return true;
 		*result = anim->m_fSeqWeight;
 		return true;
 	});
 
-	const auto getDirFilesParams = { ParamInfo{"sPath", kParamType_String, false}, { "archive type", kParamType_Integer, true } };
+	const auto getDirFilesParams = { ParamInfo{"sPath", kParamType_String, false}, { "archive type", kParamType_Integer, true }, { "bRefresh", kParamType_Integer, true } };
 	builder.Create("GetDirectoryFiles", kRetnType_Array, getDirFilesParams, false, [](COMMAND_ARGS)
 	{
 		*result = 0;
 		sv::stack_string<0x400> path;
 		auto archiveType = ARCHIVE_TYPE_ALL;
-		if (!ExtractArgs(EXTRACT_ARGS, &path, &archiveType))
+		auto refresh = 0;
+		if (!ExtractArgs(EXTRACT_ARGS, &path, &archiveType, &refresh))
 			return true;
 		path.calculate_size();
 		std::string realPath;
@@ -3007,11 +3313,11 @@ void CreateCommands(NVSECommandBuilder& builder)
 		{
 			realPath = "data\\" + std::string(path.str());
 		}
-		const auto list = FileFinder::FindFiles(!realPath.empty() ? realPath.data() : path.data(), path.data(), archiveType);
+		const auto list = FileFinder::FindFilesCached(!realPath.empty() ? realPath.data() : path.data(), path.data(), archiveType, refresh != 0);
 		NVSEArrayBuilder arr;
-		for (const auto* filePath : list)
+		for (const auto& filePath : *list)
 		{
-			arr.Add(filePath);
+			arr.Add(filePath.c_str());
 		}
 		*result = reinterpret_cast<UInt32>(arr.Build(g_arrayVarInterface, scriptObj));
 		return true;
@@ -3045,14 +3351,13 @@ void CreateCommands(NVSECommandBuilder& builder)
 	{
 		*result = 0;
 		sv::stack_string<0x400> animPath;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &animPath))
 			return true;
-		SetLowercase(animPath.data_);
-		animPath.calculate_size();
 		auto* actor = DYNAMIC_CAST(thisObj, TESForm, Actor);
 		if (!actor)
 			return true;
-		auto* additiveAnim = FindActiveAnimationForActor(actor, animPath.c_str());
+		auto* additiveAnim = FindActiveAnimationForActor(actor, GetAnimPathHandle(scriptData, argsOffset, 0, animPath.data_));
 		if (!additiveAnim)
 			return true;
 		*result = AdditiveManager::IsAdditiveSequence(additiveAnim);
@@ -3065,18 +3370,17 @@ void CreateCommands(NVSECommandBuilder& builder)
 		sv::stack_string<0x400> animPath;
 		UInt32 cycleType;
 		UInt32 firstPerson = -1;
+		const auto argsOffset = *opcodeOffsetPtr;
 		if (!ExtractArgs(EXTRACT_ARGS, &animPath, &cycleType, &firstPerson) || !thisObj)
 			return true;
 		if (cycleType > NiControllerSequence::MAX_CYCLE_TYPES)
 			return true;
-		SetLowercase(animPath.data());
-		animPath.calculate_size();
 		auto* actor = DYNAMIC_CAST(thisObj, TESForm, Actor);
 		if (!actor)
 			return true;
 		if (firstPerson == -1)
 			firstPerson = IsPlayerInFirstPerson(static_cast<Actor*>(thisObj));
-		auto* anim = FindOrLoadAnim(actor, animPath.c_str(), firstPerson);
+		auto* anim = FindOrLoadAnim(actor, GetAnimPathHandle(scriptData, argsOffset, 0, animPath.data_), firstPerson);
 		if (!anim)
 			return true;
 		anim->m_eCycleType = static_cast<NiControllerSequence::CycleType>(cycleType);
@@ -3101,7 +3405,7 @@ void CreateCommands(NVSECommandBuilder& builder)
 		auto* actor = DYNAMIC_CAST(thisObj, TESForm, Actor);
 		if (!actor)
 			return true;
-		const auto* animData = GetAnimData(actor, firstPerson);
+		auto* animData = GetAnimData(actor, firstPerson);
 		if (!animData)
 			return true;
 		auto* baseNode = animData->nBip01;
@@ -3109,25 +3413,29 @@ void CreateCommands(NVSECommandBuilder& builder)
 		auto* anim = FindOrLoadAnim(actor, animPath.c_str(), firstPerson);
 		if (!anim || !AdditiveManager::IsAdditiveSequence(anim))
 			return true;
-		auto* bone = baseNode->GetObjectByName(nodeName.c_str());
+		auto* bone = AdditiveManager::GetBone(animData, nodeName.c_str());
 		if (!bone)
 			return true;
-		const auto setNodeWeightMult = [&](this auto& self, NiAVObject* node) -> void
+		const auto isAffected = [&](const NiAVObject* node)
 		{
-			auto* block = anim->GetControlledBlock(node->m_pcName);
-			if (block)
-				AdditiveManager::SetAdditiveInterpWeightMult(node, block->m_spInterpolator, weight);
-			if (recursive)
+			if (node == bone)
+				return true;
+			if (!recursive)
+				return false;
+			for (const NiAVObject* parent = node->m_pkParent; parent; parent = parent->m_pkParent)
 			{
-				if (auto* niNode = node->GetAsNiNode())
-				{
-					for (auto* child : niNode->m_children)
-						if (child)
-							self(child);
-				}
+				if (parent == bone)
+					return true;
 			}
+			return false;
 		};
-		setNodeWeightMult(bone);
+		const auto blocks = anim->GetControlledBlocks();
+		const auto bones = AdditiveManager::GetBoneBindings(animData, anim);
+		for (size_t i = 0; i < bones.size() && i < blocks.size(); ++i)
+		{
+			if (bones[i] && isAffected(bones[i]))
+				AdditiveManager::SetAdditiveInterpWeightMult(bones[i], blocks[i].m_spInterpolator, weight);
+		}
 		*result = 1;
 		return true;
 	});
@@ -3209,6 +3517,39 @@ void CreateCommands(NVSECommandBuilder& builder)
 		return true;
 	});
 
+	// 0 = stop profiling, 1 = start profiling (discards zones recorded so far), 2 = write kNVSE_trace.json and print per-zone percentiles
+	builder.Create("kNVSEProfile", kRetnType_Default, { PARAM("action", Integer) }, false, [](COMMAND_ARGS)
+	{
+		*result = 0;
+		UInt32 action = 0;
+		if (!ExtractArgs(EXTRACT_ARGS, &action))
+			return true;
+		if (action == 0 || action == 1)
+		{
+			Profiler::SetEnabled(action == 1);
+			*result = 1;
+			return true;
+		}
+		if (action != 2)
+			return true;
+		const auto* tracePath = "kNVSE_trace.json";
+		if (!Profiler::ExportChromeTrace(tracePath))
+		{
+			ERROR_LOG(FormatString("kNVSEProfile: failed to write %s", tracePath));
+			return true;
+		}
+		DebugPrint(FormatString("kNVSEProfile: wrote %s, zone overhead %.0f ns", tracePath, Profiler::MeasureZoneOverhead()));
+		for (const auto& zone : Profiler::Summarize())
+		{
+			DebugPrint(FormatString("%s: count %u total %.2f ms avg %.2f us p50 %.2f us p90 %.2f us p99 %.2f us max %.2f us",
+				zone.name, zone.count, zone.totalMs, zone.averageUs, zone.p50Us, zone.p90Us, zone.p99Us, zone.maxUs));
+		}
+		for (const auto& counter : Profiler::SummarizeCounters())
+			DebugPrint(FormatString("%s: samples %u avg %.2f max %u", counter.name, counter.count, counter.average, counter.max));
+		*result = 1;
+		return true;
+	});
+
 #undef PARAM
 #undef OPT_PARAM
 
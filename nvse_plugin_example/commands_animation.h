@@ -23,22 +23,98 @@ extern std::span<AnimGroupInfo> g_animGroupInfos;
 using FormID = UInt32;
 using GroupID = UInt16;
 
-struct BurstFireData
+// Reverse index from an owner (actor ID or AnimData) to the keys it holds in one of the global anim containers, so
+// HandleOnAnimDataDelete only visits the owner's own entries. Guarded by the same mutex as the container it indexes.
+template <typename Owner, typename Key>
+class OwnerIndex
 {
-	bool firstPerson = false;
-	NiPointer<BSAnimGroupSequence> anim;
-	std::size_t index;
-	std::vector<NiTextKey*> hitKeys;
-	float timePassed;
-	bool shouldEject = false;
-	float lastNiTime = -FLT_MAX;
-	UInt32 actorId = 0;
-	std::vector<NiTextKey*> ejectKeys;
-	std::size_t ejectIdx = 0;
-	bool reloading = false;
+	std::unordered_map<Owner, std::vector<Key>> entries;
+
+public:
+	void Add(Owner owner, const Key& key)
+	{
+		entries[owner].push_back(key);
+	}
+
+	void Remove(Owner owner, const Key& key)
+	{
+		const auto iter = entries.find(owner);
+		if (iter == entries.end())
+			return;
+		auto& keys = iter->second;
+		if (const auto keyIter = std::ranges::find(keys, key); keyIter != keys.end())
+		{
+			*keyIter = std::move(keys.back());
+			keys.pop_back();
+		}
+		if (keys.empty())
+			entries.erase(iter);
+	}
+
+	std::vector<Key> Take(Owner owner)
+	{
+		auto node = entries.extract(owner);
+		return node.empty() ? std::vector<Key>() : std::move(node.mapped());
+	}
+
+	void Clear()
+	{
+		entries.clear();
+	}
+
+	std::size_t Size() const
+	{
+		return entries.size();
+	}
 };
 
-extern std::list<BurstFireData> g_burstFireQueue;
+// Burst fire state for every actor with a burstFire weapon anim in flight. Entries are contiguous and removed by
+// swapping in the last one; hit and eject key times share one arena. Each entry caches the anim time of its next key,
+// so entries that aren't due cost a couple of compares per frame.
+class BurstFireQueue
+{
+public:
+	struct Entry
+	{
+		NiPointer<BSAnimGroupSequence> anim = nullptr;
+		AnimData* animData = nullptr;
+		UInt32 actorId = 0;
+		UInt32 keysStart = 0; // hit key times followed by eject key times
+		UInt16 numHitKeys = 0;
+		UInt16 numEjectKeys = 0;
+		UInt16 hitIdx = 0;
+		UInt16 ejectIdx = 0;
+		float lastNiTime = -FLT_MAX;
+		float nextDueTime = -FLT_MAX;
+		bool firstPerson = false;
+		bool reloading = false;
+
+		bool HasHitKey() const { return hitIdx < numHitKeys; }
+		bool HasEjectKey() const { return ejectIdx < numEjectKeys; }
+	};
+
+	void Add(AnimData* animData, BSAnimGroupSequence* anim, bool firstPerson, std::span<const float> hitKeyTimes, std::span<const float> ejectKeyTimes);
+	void Remove(UInt32 slot);
+	void RemoveAnimData(AnimData* animData);
+	bool ContainsAnimData(AnimData* animData) const;
+
+	float GetHitKeyTime(const Entry& entry) const { return keyTimes[entry.keysStart + entry.hitIdx]; }
+	float GetEjectKeyTime(const Entry& entry) const { return keyTimes[entry.keysStart + entry.numHitKeys + entry.ejectIdx]; }
+	void UpdateNextDueTime(Entry& entry) const;
+
+	Entry& operator[](UInt32 slot) { return entries[slot]; }
+	UInt32 Size() const { return entries.size(); }
+
+private:
+	void CompactKeyTimes();
+
+	std::vector<Entry> entries;
+	std::vector<float> keyTimes;
+	UInt32 numLiveKeyTimes = 0;
+	OwnerIndex<AnimData*, UInt32> slotsByAnimData;
+};
+
+extern BurstFireQueue g_burstFireQueue;
 
 enum class POVSwitchState
 {
@@ -375,12 +451,67 @@ struct JSONAnimContext
 
 using TimeTrackedAnimsMap = std::unordered_map<BSAnimGroupSequence*, std::unique_ptr<AnimTime>>;
 extern TimeTrackedAnimsMap g_timeTrackedAnims;
+extern OwnerIndex<UInt32, BSAnimGroupSequence*> g_timeTrackedAnimsByActor;
 void EraseTimeTrackedAnim(BSAnimGroupSequence* anim);
 
 using TimeTrackedGroupsKey = std::pair<SavedAnims*, AnimData*>;
-using TimeTrackedGroupsPair = std::pair<const TimeTrackedGroupsKey, std::unique_ptr<SavedAnimsTime>>;
-using TimeTrackedGroupsMap = std::unordered_map<TimeTrackedGroupsKey, std::unique_ptr<SavedAnimsTime>, pair_hash, pair_equal>;
-extern TimeTrackedGroupsMap g_timeTrackedGroups;
+
+// Anim groups with pollCondition whose condition script is re-evaluated while they play. Entries live in a persistent
+// array; erasing leaves a tombstone that a later insert reuses with a new generation, so the poll loop can tell if an
+// entry was erased or replaced while a condition script ran. Each entry is polled every pollInterval frames, staggered
+// by slot, and at most budget entries are polled per frame, starting next frame with the first one deferred.
+class TimeTrackedGroups
+{
+public:
+	struct Entry
+	{
+		SavedAnims* savedAnims = nullptr; // nullptr marks a tombstone
+		SavedAnimsTime time;
+		UInt32 generation = 0;
+		UInt32 nextPollFrame = 0;
+		UInt32 pollInterval = 1;
+	};
+
+	struct FrameStats
+	{
+		UInt32 tracked = 0;
+		UInt32 polled = 0;
+		UInt32 deferred = 0; // due but over budget
+		UInt32 erased = 0;
+	};
+
+	SavedAnimsTime& GetOrCreate(SavedAnims* savedAnims, AnimData* animData, UInt32 pollInterval);
+	void Erase(UInt32 slot, UInt32 generation);
+	void EraseAnimData(AnimData* animData);
+	bool ContainsAnimData(AnimData* animData) const;
+	void Clear();
+	bool Empty() const { return lookup.empty(); }
+
+	// poll loop: BeginFrame, then NextDue until it returns false; entries added meanwhile wait for the next frame
+	void BeginFrame(UInt32 frameBudget);
+	bool NextDue(UInt32& slot);
+	Entry& operator[](UInt32 slot) { return entries[slot]; }
+
+	const FrameStats& GetFrameStats() const { return stats; }
+
+private:
+	void EraseSlot(UInt32 slot);
+
+	std::vector<Entry> entries;
+	std::vector<UInt32> freeSlots;
+	std::unordered_map<TimeTrackedGroupsKey, UInt32, pair_hash, pair_equal> lookup;
+	OwnerIndex<AnimData*, SavedAnims*> keysByAnimData;
+	UInt32 frame = 0;
+	UInt32 nextGeneration = 1;
+	UInt32 scanStart = 0;
+	UInt32 scanEnd = 0;
+	UInt32 scanned = 0;
+	UInt32 nextScanStart = 0;
+	UInt32 budget = 0;
+	FrameStats stats;
+};
+
+extern TimeTrackedGroups g_timeTrackedGroups;
 
 #define THISCALL(address, returnType, ...) reinterpret_cast<returnType(__thiscall*)(__VA_ARGS__)>(address)
 #define _CDECL(address, returnType, ...) reinterpret_cast<returnType(__cdecl*)(__VA_ARGS__)>(address)
@@ -553,7 +684,25 @@ bool IsAnimGroupMovement(UInt8 animGroupId);
 
 bool WeaponHasNthMod(Decoding::ContChangesEntry* weaponInfo, TESObjectWEAP* weap, UInt32 mod);
 
+// Lowercased, pooled anim path taken by a command. Handles are interned per path and cached per script call site (see
+// GetAnimPathHandle), so a script passing the same literal every frame doesn't lowercase, pool or hash it again.
+struct AnimPathHandle
+{
+	std::string_view path;
+	// last sequence found under this path and its slot in the manager's sequences; holds no reference, so it's only
+	// reused while that slot of the same manager still holds it (see FindActiveAnimationByPath)
+	NiControllerManager* lastManager = nullptr;
+	BSAnimGroupSequence* lastAnim = nullptr;
+	UInt32 lastIndex = 0;
+
+	explicit AnimPathHandle(std::string_view path) : path(path) {}
+};
+
+// argsOffset is *opcodeOffsetPtr before ExtractArgs, argIndex tells apart several paths of the same command
+AnimPathHandle& GetAnimPathHandle(const void* scriptData, UInt32 argsOffset, UInt32 argIndex, const char* path);
+
 BSAnimGroupSequence* FindOrLoadAnim(AnimData* animData, const char* path);
+BSAnimGroupSequence* FindOrLoadAnim(AnimData* animData, AnimPathHandle& path);
 
 int GetWeaponInfoClipSize(Actor* actor);
 
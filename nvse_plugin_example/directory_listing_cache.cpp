@@ -0,0 +1,81 @@
+﻿#include "directory_listing_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    struct DirectoryListing
+    {
+        DirectoryListingCache::FileList files;
+        // of the loose folder, file_time_type::min() if it doesn't exist; unused for archive listings
+        std::filesystem::file_time_type lastWriteTime;
+    };
+
+    std::unordered_map<std::string, DirectoryListing> g_directoryListings;
+    std::mutex g_directoryListingsMutex;
+
+    DirectoryListingCache::FileList GetOrCreateListing(const std::string& key, std::filesystem::file_time_type lastWriteTime,
+        bool forceRefresh, const DirectoryListingCache::CreateList& createList)
+    {
+        {
+            std::unique_lock lock(g_directoryListingsMutex);
+            if (const auto iter = g_directoryListings.find(key); iter != g_directoryListings.end() && !forceRefresh
+                && iter->second.lastWriteTime == lastWriteTime)
+                return iter->second.files;
+        }
+        // scanned without holding the lock, a listing requested by two threads at once is just scanned twice
+        DirectoryListingCache::FileList files = std::make_shared<const std::vector<std::string>>(createList());
+        std::unique_lock lock(g_directoryListingsMutex);
+        g_directoryListings[key] = DirectoryListing{ files, lastWriteTime };
+        return files;
+    }
+}
+
+std::string DirectoryListingCache::NormalizePath(std::string_view path)
+{
+    std::string result;
+    result.reserve(path.size());
+    for (auto c : path)
+    {
+        if (c == '/')
+            c = '\\';
+        if (c == '\\' && !result.empty() && result.back() == '\\')
+            continue;
+        result.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    return result;
+}
+
+std::filesystem::file_time_type DirectoryListingCache::GetLooseFolderWriteTime(std::string_view searchPath)
+{
+    std::string folder(searchPath);
+    if (const auto pos = folder.find_last_of("\\/"); pos != std::string::npos && folder.find_first_of("*?", pos) != std::string::npos)
+        folder.resize(pos);
+    // no-op on Windows, lets the same paths be checked against a real tree elsewhere
+    std::replace(folder.begin(), folder.end(), '\\', static_cast<char>(std::filesystem::path::preferred_separator));
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(std::filesystem::path(folder), ec);
+    return ec ? std::filesystem::file_time_type::min() : time;
+}
+
+DirectoryListingCache::FileList DirectoryListingCache::GetFolderListing(std::string_view path, std::string_view renameDirectory,
+    std::uint32_t archiveType, bool forceRefresh, const CreateList& createList)
+{
+    const auto searchPath = NormalizePath(path);
+    const auto key = searchPath + '|' + NormalizePath(renameDirectory) + '|' + std::to_string(archiveType);
+    return GetOrCreateListing(key, GetLooseFolderWriteTime(searchPath), forceRefresh, createList);
+}
+
+DirectoryListingCache::FileList DirectoryListingCache::GetArchiveListing(std::string_view path, const CreateList& createList)
+{
+    return GetOrCreateListing("bsa|" + NormalizePath(path), {}, false, createList);
+}
+
+void DirectoryListingCache::Clear()
+{
+    std::unique_lock lock(g_directoryListingsMutex);
+    g_directoryListings.clear();
+}
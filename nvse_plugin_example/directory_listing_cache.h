@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Mtime-keyed cache of directory listings used by FileFinder. No game types, the scan itself is passed in as a callback,
+// see tests/directory_listing_cache_test.cpp.
+namespace DirectoryListingCache
+{
+    using FileList = std::shared_ptr<const std::vector<std::string>>;
+    using CreateList = std::function<std::vector<std::string>()>;
+
+    // lowercase, '/' turned into '\' and repeated separators collapsed so equivalent paths share a cache entry
+    std::string NormalizePath(std::string_view path);
+    // modification time of the folder a search pattern looks in (data\meshes\folder\*.kf -> data\meshes\folder),
+    // file_time_type::min() if it doesn't exist
+    std::filesystem::file_time_type GetLooseFolderWriteTime(std::string_view searchPath);
+
+    // listing of a search path, createList is called again once the loose folder's modification time changes or when
+    // forceRefresh is set
+    FileList GetFolderListing(std::string_view path, std::string_view renameDirectory, std::uint32_t archiveType, bool forceRefresh,
+        const CreateList& createList);
+    // listing of archive contents, created once per session since archives don't change while the game runs
+    FileList GetArchiveListing(std::string_view path, const CreateList& createList);
+    // drops all cached listings, lists already handed out stay valid
+    void Clear();
+}
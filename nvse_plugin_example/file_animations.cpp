@@ -11,6 +11,7 @@
 #include <utility>
 #include <type_traits>
 
+#include "profiler.h"
 #include "string_view_util.h"
 #include "bethesda/bethesda_types.h"
 
@@ -275,11 +276,11 @@ int OverrideBSAPathAnimationsForRange(AnimOverrideData& animOverrideData, std::r
 
 int OverrideBSAPathAnimationsForList(AnimOverrideData& animOverrideData, std::string_view basePath)
 {
-	const auto list = ArchiveManager::GetDirectoryAnimPaths(basePath);
-	if (list.Empty())
+	const auto list = FileFinder::GetArchiveDirectoryAnimPaths(basePath);
+	if (list->empty())
 		return 0;
 	int numFound = 0;
-	for (const char* pPath : list)
+	for (const auto& pPath : *list)
 	{
 		const std::string_view path(pPath);
 		if (!path.starts_with(basePath))
@@ -412,6 +413,7 @@ void LoadAnimPathsFromBSA(const fs::path& path, std::vector<std::string_view>& a
 
 void LoadFileAnimPaths()
 {
+	PROFILE_ZONE("LoadFileAnimPaths");
 	ScopedTimer timer("Loaded AnimGroupOverride");
 	LOG("Loading file anims");
 
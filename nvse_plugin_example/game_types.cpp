@@ -217,6 +217,41 @@ ScopedList<char> FileFinder::FindFiles(const char* path, const char* renameDirec
 	return std::move(*result);
 }
 
+namespace
+{
+	std::vector<std::string> MakeFileList(const ScopedList<char>& list)
+	{
+		std::vector<std::string> files;
+		for (const auto* path : list)
+		{
+			if (path)
+				files.emplace_back(path);
+		}
+		return files;
+	}
+}
+
+FileFinder::FileList FileFinder::FindFilesCached(const char* path, const char* renameDirectory, ARCHIVE_TYPE archiveType, bool forceRefresh)
+{
+	return DirectoryListingCache::GetFolderListing(path, renameDirectory, archiveType, forceRefresh, [&]
+	{
+		return MakeFileList(FindFiles(path, renameDirectory, archiveType));
+	});
+}
+
+FileFinder::FileList FileFinder::GetArchiveDirectoryAnimPaths(std::string_view path)
+{
+	return DirectoryListingCache::GetArchiveListing(path, [&]
+	{
+		return MakeFileList(ArchiveManager::GetDirectoryAnimPaths(path));
+	});
+}
+
+void FileFinder::ClearCache()
+{
+	DirectoryListingCache::Clear();
+}
+
 AnimGroupInfo* GetGroupInfo(AnimGroupID groupId)
 {
 	return &g_animGroupInfos[groupId];
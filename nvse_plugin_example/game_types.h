@@ -1,4 +1,5 @@
 #pragma once
+#include "directory_listing_cache.h"
 #include "GameObjects.h"
 #include "GameOSDepend.h"
 #include "utility.h"
@@ -1063,6 +1064,16 @@ public:
 namespace FileFinder
 {
 	ScopedList<char> FindFiles(const char* path, const char* renameDirectory, ARCHIVE_TYPE archiveType);
+
+	using FileList = DirectoryListingCache::FileList;
+
+	// FindFiles with the result cached per path and archive type, rescanned once the loose folder's modification time
+	// changes (files added, removed or renamed in it) or when forceRefresh is set
+	FileList FindFilesCached(const char* path, const char* renameDirectory, ARCHIVE_TYPE archiveType, bool forceRefresh = false);
+	// ArchiveManager::GetDirectoryAnimPaths, cached for the session since archives don't change while the game runs
+	FileList GetArchiveDirectoryAnimPaths(std::string_view path);
+	// drops all cached listings
+	void ClearCache();
 }
 
 class BSWin32Audio
@@ -15,6 +15,7 @@
 #include "utility.h"
 #include "main.h"
 #include "nihooks.h"
+#include "profiler.h"
 #include "blend_fixes.h"
 #include "blend_smoothing.h"
 #include "knvse_events.h"
@@ -25,24 +26,154 @@ bool g_startedAnimation = false;
 BSAnimGroupSequence* g_lastLoopSequence = nullptr;
 extern bool g_fixHolster;
 
-std::map<std::pair<FullAnimGroupID, AnimData*>, std::deque<BSAnimGroupSequence*>> g_queuedReplaceAnims;
+QueuedAnimMap g_queuedReplaceAnims;
 
+void QueuedAnimMap::Queue::Push(BSAnimGroupSequence* anim)
+{
+	if (count == capacity)
+	{
+		auto newAnims = std::make_unique<BSAnimGroupSequence*[]>(capacity * 2);
+		for (UInt16 i = 0; i < count; ++i)
+			newAnims[i] = Data()[(head + i) & (capacity - 1)];
+		heapAnims = std::move(newAnims);
+		head = 0;
+		capacity *= 2;
+	}
+	Data()[(head + count++) & (capacity - 1)] = anim;
+}
 
-BSAnimGroupSequence* GetQueuedAnim(AnimData* animData, FullAnimGroupID animGroupId)
+BSAnimGroupSequence* QueuedAnimMap::Queue::Pop()
+{
+	auto* anim = Data()[head];
+	head = (head + 1) & (capacity - 1);
+	--count;
+	return anim;
+}
+
+bool QueuedAnimMap::Queue::Contains(BSAnimGroupSequence* anim) const
+{
+	for (UInt16 i = 0; i < count; ++i)
+	{
+		if (Data()[(head + i) & (capacity - 1)] == anim)
+			return true;
+	}
+	return false;
+}
+
+static UInt32 HashQueuedAnimKey(AnimData* animData, FullAnimGroupID groupId)
+{
+	return (reinterpret_cast<UInt32>(animData) * 0x9E3779B1) ^ (groupId * 0x85EBCA6B);
+}
+
+UInt32 QueuedAnimMap::FindSlot(AnimData* animData, FullAnimGroupID groupId) const
 {
-	const auto key = std::make_pair(animGroupId, animData);
-	const auto it = g_queuedReplaceAnims.find(key);
-	if (it != g_queuedReplaceAnims.end())
+	if (slots.empty())
+		return UINT32_MAX;
+	const UInt32 mask = slots.size() - 1;
+	for (UInt32 index = HashQueuedAnimKey(animData, groupId) & mask;; index = (index + 1) & mask)
+	{
+		const auto& slot = slots[index];
+		if (!slot.animData)
+			return UINT32_MAX;
+		if (slot.animData == animData && slot.groupId == groupId)
+			return index;
+	}
+}
+
+void QueuedAnimMap::EraseSlot(UInt32 index)
+{
+	// shift back following entries of the probe run so lookups never stop at the hole
+	const UInt32 mask = slots.size() - 1;
+	for (UInt32 next = (index + 1) & mask; slots[next].animData; next = (next + 1) & mask)
 	{
-		auto& queue = it->second;
-		if (!queue.empty())
+		const UInt32 home = HashQueuedAnimKey(slots[next].animData, slots[next].groupId) & mask;
+		if (((next - home) & mask) >= ((next - index) & mask))
 		{
-			auto* anim = queue.front();
-			queue.pop_front();
-			return anim;
+			slots[index] = std::move(slots[next]);
+			index = next;
 		}
 	}
-	return nullptr;
+	slots[index] = Slot();
+	--numUsed;
+}
+
+void QueuedAnimMap::Grow()
+{
+	auto oldSlots = std::move(slots);
+	slots = std::vector<Slot>(oldSlots.empty() ? 8 : oldSlots.size() * 2);
+	const UInt32 mask = slots.size() - 1;
+	for (auto& slot : oldSlots)
+	{
+		if (!slot.animData)
+			continue;
+		UInt32 index = HashQueuedAnimKey(slot.animData, slot.groupId) & mask;
+		while (slots[index].animData)
+			index = (index + 1) & mask;
+		slots[index] = std::move(slot);
+	}
+}
+
+void QueuedAnimMap::Push(AnimData* animData, FullAnimGroupID groupId, BSAnimGroupSequence* anim)
+{
+	UInt32 index = FindSlot(animData, groupId);
+	if (index == UINT32_MAX)
+	{
+		if ((numUsed + 1) * 4 > slots.size() * 3)
+			Grow();
+		const UInt32 mask = slots.size() - 1;
+		index = HashQueuedAnimKey(animData, groupId) & mask;
+		while (slots[index].animData)
+			index = (index + 1) & mask;
+		slots[index].animData = animData;
+		slots[index].groupId = groupId;
+		++numUsed;
+	}
+	slots[index].queue.Push(anim);
+	++queuedPerBucket[GetBucket(animData)];
+}
+
+BSAnimGroupSequence* QueuedAnimMap::Pop(AnimData* animData, FullAnimGroupID groupId)
+{
+	if (!MayHaveQueued(animData))
+		return nullptr;
+	const UInt32 index = FindSlot(animData, groupId);
+	if (index == UINT32_MAX)
+		return nullptr;
+	auto* anim = slots[index].queue.Pop();
+	--queuedPerBucket[GetBucket(animData)];
+	if (!slots[index].queue.Size())
+		EraseSlot(index);
+	return anim;
+}
+
+bool QueuedAnimMap::Contains(AnimData* animData, FullAnimGroupID groupId, BSAnimGroupSequence* anim) const
+{
+	if (!MayHaveQueued(animData))
+		return false;
+	const UInt32 index = FindSlot(animData, groupId);
+	return index != UINT32_MAX && slots[index].queue.Contains(anim);
+}
+
+void QueuedAnimMap::RemoveAnimData(AnimData* animData)
+{
+	if (!MayHaveQueued(animData))
+		return;
+	for (UInt32 index = 0; index < slots.size();)
+	{
+		if (slots[index].animData == animData)
+		{
+			queuedPerBucket[GetBucket(animData)] -= slots[index].queue.Size();
+			// erasing may shift a later entry into this slot, so check it again
+			EraseSlot(index);
+			continue;
+		}
+		++index;
+	}
+}
+
+BSAnimGroupSequence* GetQueuedAnim(AnimData* animData, FullAnimGroupID animGroupId)
+{
+	return g_queuedReplaceAnims.Pop(animData, animGroupId);
 }
 
 void Apply3rdPersonRespectEndKeyEaseInFix(AnimData* animData, BSAnimGroupSequence* anim3rd);
@@ -50,6 +181,7 @@ void Apply3rdPersonRespectEndKeyEaseInFix(AnimData* animData, BSAnimGroupSequenc
 // UInt32 animGroupId, BSAnimGroupSequence** toMorph, UInt8* basePointer
 BSAnimGroupSequence* __fastcall HandleAnimationChange(AnimData* animData, void*, BSAnimGroupSequence* destAnim, UInt16 animGroupId, eAnimSequence animSequence)
 {
+	PROFILE_ZONE("HandleAnimationChange");
 	const auto baseAnimGroup = static_cast<AnimGroupID>(animGroupId);
 
 	if (animData && animData->actor)
@@ -619,6 +751,8 @@ void ApplyHooks()
 	}
 	g_logLevel = ini.GetOrCreate("General", "iConsoleLogLevel", 1, "; 0 = no log, 1 = kNVSE.log, 2 = console log");
 	g_errorLogLevel = ini.GetOrCreate("General", "iErrorLogLevel", 1, "; 0 = no log, 1 = kNVSE.log, 2 = error console log");
+	if (ini.GetOrCreate("General", "bAsyncLog", 0, "; write kNVSE.log from a background thread to keep per-animation logging off the game thread"))
+		gLog.StartAsync();
 	auto& conf = g_pluginSettings;
 
 #if 0
@@ -641,6 +775,10 @@ void ApplyHooks()
 	{
 		conf.legacyAnimTimePaths = SplitString(legacyAnimTimePaths);
 	}
+	conf.pollConditionInterval = std::max(ini.GetOrCreate("General", "iPollConditionInterval", 1, "; evaluate pollCondition scripts of NPC animations every this many frames, spread out across frames (player animations are always evaluated every frame)"), 1);
+	conf.pollConditionBudget = std::max(ini.GetOrCreate("General", "iPollConditionBudget", 0, "; max number of pollCondition scripts evaluated per frame, the rest are evaluated first thing next frame (0 = no limit)"), 0);
+	Profiler::SetEnabled(ini.GetOrCreate("General", "bProfiler", 0, "; record frame timings from startup, see the kNVSEProfile console command"));
+	conf.cacheCompiledScripts = ini.GetOrCreate("General", "bCacheCompiledScripts", 1, "; save compiled condition and scriptLine scripts to Data\\NVSE\\Plugins\\kNVSE_scripts.cache so they don't have to be compiled again next game start (rebuilt when the load order changes)");
 	//WriteRelJump(0x4949D0, AnimationHook);
 	
 	WriteRelCall(0x494989, HandleAnimationChange);
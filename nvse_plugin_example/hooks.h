@@ -33,6 +33,10 @@ struct PluginINISettings
 
     bool fixDeactivateControllerManagers = true;
     std::vector<std::string> legacyAnimTimePaths;
+
+    UInt32 pollConditionInterval = 1;
+    UInt32 pollConditionBudget = 0;
+    bool cacheCompiledScripts = true;
 };
 extern PluginINISettings g_pluginSettings;
 
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// Thread-safe map that keeps the kMaxEntries most recently used values. Keys are stored by value and must own whatever
+// they compare by, an entry can outlive everything else that refers to its key. No game types, see tests/lru_cache_test.cpp.
+template <typename Key, typename Value, typename Hash, std::size_t kMaxEntries>
+class LruCache
+{
+public:
+    struct Stats
+    {
+        std::uint32_t hits = 0;
+        std::uint32_t misses = 0;
+        std::uint32_t evictions = 0;
+    };
+
+    // value cached for key, a default constructed Value if there is none
+    Value Get(const Key& key)
+    {
+        std::unique_lock lock(mutex);
+        const auto iter = entries.find(key);
+        if (iter == entries.end())
+        {
+            ++stats.misses;
+            return Value();
+        }
+        ++stats.hits;
+        lru.splice(lru.begin(), lru, iter->second.lruIter);
+        return iter->second.value;
+    }
+
+    void Add(const Key& key, Value value)
+    {
+        std::unique_lock lock(mutex);
+        if (const auto iter = entries.find(key); iter != entries.end())
+        {
+            iter->second.value = std::move(value);
+            lru.splice(lru.begin(), lru, iter->second.lruIter);
+            return;
+        }
+        if (entries.size() >= kMaxEntries)
+        {
+            entries.erase(lru.back());
+            lru.pop_back();
+            ++stats.evictions;
+        }
+        lru.push_front(key);
+        entries.emplace(key, Entry{ std::move(value), lru.begin() });
+    }
+
+    // drops every entry, returns the stats since the last Clear
+    Stats Clear()
+    {
+        std::unique_lock lock(mutex);
+        const auto oldStats = stats;
+        entries.clear();
+        lru.clear();
+        stats = Stats();
+        return oldStats;
+    }
+
+    std::size_t Size()
+    {
+        std::unique_lock lock(mutex);
+        return entries.size();
+    }
+
+private:
+    struct Entry
+    {
+        Value value;
+        typename std::list<Key>::iterator lruIter;
+    };
+
+    std::unordered_map<Key, Entry, Hash> entries;
+    std::list<Key> lru;
+    Stats stats;
+    std::mutex mutex;
+};
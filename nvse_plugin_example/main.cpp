@@ -18,6 +18,8 @@
 #include <thread>
 
 #include "knvse_version.h"
+#include "profiler.h"
+#include "script_cache.h"
 #include "LambdaVariableContext.h"
 #include "nihooks.h"
 #include "NiObjects.h"
@@ -194,53 +196,38 @@ bool IsActorInvalid(Actor* actor)
 
 void HandlePollConditionAnims()
 {
+	PROFILE_ZONE("HandlePollConditionAnims");
 	std::unique_lock lock(g_pollConditionMutex);
-	if (g_timeTrackedGroups.empty())
-		return;
-#if _DEBUG && 0
-	struct DebugInfo
-	{
-		std::string_view anim;
-		FullAnimGroupID groupId;
-		std::string_view conditionScript;
-		std::string_view actorName;
-	};
-	std::vector<DebugInfo> anims;
-	for (const auto& [pair, animTimePtr] : g_timeTrackedGroups)
+	if (Profiler::IsEnabled())
 	{
-		const auto& ctx = *pair.first;
-		if (pair.first->conditionScriptText.empty())
-		{
-			pair.first->conditionScriptText = AddStringToPool(DecompileScript(*pair.first->conditionScript));
-		}
-		auto* actor = DYNAMIC_CAST(LookupFormByRefID(animTimePtr->actorId), TESForm, Actor);
-		std::string_view actorName = actor ? actor->GetFullName()->name.CStr() : "NULL";
-		anims.emplace_back(ctx.anims.front()->path, animTimePtr->groupId, pair.first->conditionScriptText, actorName);
-	}
-#endif
-
-	std::vector<std::pair<TimeTrackedGroupsKey, SavedAnimsTime*>> trackedGroups;
-	trackedGroups.reserve(g_timeTrackedGroups.size());
-	
-	for (auto& [pair, animTimePtr] : g_timeTrackedGroups)
-	{
-		trackedGroups.emplace_back(pair, animTimePtr.get());
+		// counts of the frame that just ended, BeginFrame resets them
+		const auto& stats = g_timeTrackedGroups.GetFrameStats();
+		Profiler::RecordCounter("pollCondition tracked", stats.tracked);
+		Profiler::RecordCounter("pollCondition polled", stats.polled);
+		Profiler::RecordCounter("pollCondition deferred", stats.deferred);
+		Profiler::RecordCounter("pollCondition erased", stats.erased);
 	}
+	g_timeTrackedGroups.BeginFrame(g_pluginSettings.pollConditionBudget);
+	if (g_timeTrackedGroups.Empty())
+		return;
 
 	const auto playAnimGroup = [](AnimData* animData, const UInt16 groupId)
 	{
 		GameFuncs::PlayAnimGroup(animData, groupId, 1, -1, -1);
 	};
 
-	for (auto& [key, animTimePtr] : trackedGroups)
+	UInt32 slot;
+	while (g_timeTrackedGroups.NextDue(slot))
 	{
+		// copy everything out, condition scripts and PlayAnimGroup can add or erase entries
+		const auto& entry = g_timeTrackedGroups[slot];
+		const auto generation = entry.generation;
+		const auto& ctx = *entry.savedAnims;
+		auto [conditionScript, groupId, actorId, animData] = entry.time;
 		const auto erase = [&]
 		{
-			g_timeTrackedGroups.erase(key);
+			g_timeTrackedGroups.Erase(slot, generation);
 		};
-		auto animTime = *animTimePtr;
-		auto [conditionScript, groupId, actorId, animData] = animTime;
-		const auto& ctx = *key.first;
 		auto* actor = static_cast<Actor*>(LookupFormByRefID(actorId));
 		
 		if (IsActorInvalid(actor) || !animData || !conditionScript || ctx.disabled)
@@ -325,6 +312,7 @@ struct SetThisAnimScriptPath
 
 void HandleCustomTextKeys()
 {
+	PROFILE_ZONE("HandleCustomTextKeys");
 	std::unique_lock lock(g_animTimeMutex);
 	for (auto it = g_timeTrackedAnims.begin(); it != g_timeTrackedAnims.end();)
 	{
@@ -341,6 +329,7 @@ void HandleCustomTextKeys()
 					g_script->CallFunctionAlt(cleanUpScript, actor, 2, path.c_str(), animTime.firstPerson);
 				}
 			}
+			g_timeTrackedAnimsByActor.Remove(animTime.actorId, it->first);
 			it = g_timeTrackedAnims.erase(it);
 		};
 
@@ -533,6 +522,7 @@ void HandleCustomTextKeys()
 
 void HandleAnimTimes()
 {
+	PROFILE_ZONE("HandleAnimTimes");
 	HandleCustomTextKeys();
 	HandlePollConditionAnims();
 }
@@ -545,45 +535,47 @@ bool IsGodMode()
 
 void HandleBurstFire()
 {
-	auto iter = g_burstFireQueue.begin();
-	while (iter != g_burstFireQueue.end())
+	PROFILE_ZONE("HandleBurstFire");
+	for (UInt32 slot = 0; slot < g_burstFireQueue.Size();)
 	{
-		auto& [firstPerson, anim, index, hitKeys, _, shouldEject, lastNiTime, actorId, ejectKeys, ejectIdx, reloading] = *iter;
+		auto& entry = g_burstFireQueue[slot];
+		BSAnimGroupSequence* anim = entry.anim;
 		const auto erase = [&]()
 		{
-			iter = g_burstFireQueue.erase(iter);
+			g_burstFireQueue.Remove(slot);
 		};
-		auto* actor = DYNAMIC_CAST(LookupFormByRefID(actorId), TESForm, Actor);
-		if (!actor || actor->IsDeleted() || actor->IsDying(true) || !anim || !anim->animGroup || anim->m_fLastScaledTime - lastNiTime < -0.01f && anim->m_eCycleType != NiControllerSequence::LOOP)
+		// anim restarting or no longer playing ends the burst; entries are removed with their AnimData so it's safe to read
+		if (!anim || !anim->animGroup || anim->m_fLastScaledTime - entry.lastNiTime < -0.01f && anim->m_eCycleType != NiControllerSequence::LOOP
+			|| entry.animData->animSequence[kSequence_Weapon] != anim)
 		{
 			erase();
 			continue;
 		}
-		auto* animData = firstPerson ? g_thePlayer->firstPersonAnimData : actor->baseProcess->GetAnimData();
-		if (!animData)
+		entry.lastNiTime = anim->m_fLastScaledTime;
+		//timePassed += GetTimePassed(animData, anim->animGroup->groupID);
+		const auto timePassed = anim->m_fLastScaledTime;
+		// first hit handled by engine
+		// don't want duplicated shootings
+		if (timePassed <= entry.nextDueTime || timePassed <= anim->animGroup->keyTimes[kSeqState_HitOrDetach])
 		{
-			erase();
+			++slot;
 			continue;
 		}
-		lastNiTime = anim->m_fLastScaledTime;
-		auto* currentAnim = animData->animSequence[kSequence_Weapon];
-		auto* weapon = actor->GetWeaponForm();
-		if (currentAnim != anim)
+		auto* actor = DYNAMIC_CAST(LookupFormByRefID(entry.actorId), TESForm, Actor);
+		if (!actor || actor->IsDeleted() || actor->IsDying(true))
 		{
 			erase();
 			continue;
 		}
-		//timePassed += GetTimePassed(animData, anim->animGroup->groupID);
-		const auto timePassed = anim->m_fLastScaledTime;
-		if (timePassed <= anim->animGroup->keyTimes[kSeqState_HitOrDetach])
+		auto* animData = entry.firstPerson ? g_thePlayer->firstPersonAnimData : actor->baseProcess->GetAnimData();
+		if (animData != entry.animData)
 		{
-			// first hit handled by engine
-			// don't want duplicated shootings
-			++iter;
+			erase();
 			continue;
 		}
-		const auto passedHitKey = index < hitKeys.size() && timePassed > hitKeys.at(index)->m_fTime;
-		const auto passedEjectKey = ejectIdx < ejectKeys.size() && !ejectKeys.empty() && ejectIdx < ejectKeys.size() && timePassed > ejectKeys.at(ejectIdx)->m_fTime;
+		auto* weapon = actor->GetWeaponForm();
+		const auto passedHitKey = entry.HasHitKey() && timePassed > g_burstFireQueue.GetHitKeyTime(entry);
+		const auto passedEjectKey = entry.HasEjectKey() && timePassed > g_burstFireQueue.GetEjectKeyTime(entry);
 		if (passedHitKey || passedEjectKey)
 		{
 			if (auto* ammoInfo = actor->baseProcess->GetAmmoInfo()) // static_cast<Decoding::MiddleHighProcess*>(animData->actor->baseProcess)->ammoInfo
@@ -594,7 +586,7 @@ void HandleBurstFire()
 					if (ammoInfo->count == 0 || actor->IsAnimActionReload())
 					{
 						// reloaded
-						reloading = true;
+						entry.reloading = true;
 					}
 #if 0
 					const auto ammoCount = ammoInfo->countDelta;
@@ -607,31 +599,27 @@ void HandleBurstFire()
 				}
 			}
 			if (passedHitKey)
-				++index;
+				++entry.hitIdx;
 			if (!IsPlayersOtherAnimData(animData))
 			{
-				bool ejected = false;
-				if (passedHitKey)
-				{
-					if (!reloading)
-						actor->FireWeapon();
-					if (!passedEjectKey && ejectKeys.empty() || ejectIdx == ejectKeys.size())
-					{
-						if (!reloading)
-							actor->EjectFromWeapon(weapon);
-						ejected = true;
-					}
-				}
-				if (!ejected && passedEjectKey)
-				{
+				const auto reloading = entry.reloading;
+				const auto ejectWithHit = passedHitKey && (!passedEjectKey && !entry.numEjectKeys || entry.ejectIdx == entry.numEjectKeys);
+				const auto ejectOnKey = !ejectWithHit && passedEjectKey;
+				if (ejectOnKey)
+					++entry.ejectIdx;
+				// firing can play anims which add to the queue, so entry may be reallocated past this point
+				if (passedHitKey && !reloading)
+					actor->FireWeapon();
+				if (ejectWithHit && !reloading || ejectOnKey)
 					actor->EjectFromWeapon(weapon);
-					++ejectIdx;
-				}
 			}
 		}
 		
-		if (index < hitKeys.size() || !ejectKeys.empty() && ejectIdx < ejectKeys.size())
-			++iter;
+		if (auto& current = g_burstFireQueue[slot]; current.HasHitKey() || current.HasEjectKey())
+		{
+			g_burstFireQueue.UpdateNextDueTime(current);
+			++slot;
+		}
 		else
 			erase();
 	}
@@ -639,6 +627,7 @@ void HandleBurstFire()
 
 void HandleSynchronizedExecutionQueue()
 {
+	PROFILE_ZONE("HandleSynchronizedExecutionQueue");
 	ScopedLock lock(g_executionQueueCS);
 	while (!g_synchronizedExecutionQueue.empty())
 	{
@@ -691,6 +680,7 @@ void SynchronizedQueue::RunAllAndClear()
 
 void HandleMisc()
 {
+	PROFILE_ZONE("HandleMisc");
 	ApplyHolsterFix();
 	OnReloadHandler::Update();
 	ClearResultCaches();
@@ -707,10 +697,12 @@ void MessageHandler(NVSEMessagingInterface::Message* msg)
 		Console_Print("kNVSE version %d", VERSION_MAJOR);
 		WriteDelayedHooks();
 		g_thePlayer = *reinterpret_cast<PlayerCharacter**>(0x011DEA3C);
+		CompiledScriptCache::Load();
 		g_animFileThread = std::thread(LoadFileAnimPaths);
 	}
 	else if (msg->type == NVSEMessagingInterface::kMessage_MainGameLoop)
 	{
+		PROFILE_ZONE("MainGameLoop");
 		const auto isMenuMode = CdeclCall<bool>(0x702360);
 		if (!isMenuMode)
 		{
@@ -730,6 +722,12 @@ void MessageHandler(NVSEMessagingInterface::Message* msg)
 	else if (msg->type == NVSEMessagingInterface::kMessage_PostLoadGame)
 	{
 		// HandleGarbageCollection();
+		CompiledScriptCache::Save();
+	}
+	else if (msg->type == NVSEMessagingInterface::kMessage_ExitToMainMenu || msg->type == NVSEMessagingInterface::kMessage_ExitGame
+		|| msg->type == NVSEMessagingInterface::kMessage_ExitGame_Console)
+	{
+		CompiledScriptCache::Save();
 	}
 }
 
@@ -34,7 +34,66 @@ extern NVSEStringVarInterface* g_stringVarInterface;
 extern std::unordered_map<std::string, std::vector<CustomAnimGroupScript>> g_customAnimGroups;
 using AnimGroupPathsMap = std::unordered_map<std::string, std::unordered_set<std::string>, transparent_string_hash, std::equal_to<>>;
 extern AnimGroupPathsMap g_customAnimGroupPaths;
-extern std::map<std::pair<FullAnimGroupID, AnimData*>, std::deque<BSAnimGroupSequence*>> g_queuedReplaceAnims;
+
+// Anims queued with QueueNextAnim, per AnimData and anim group. HandleAnimationChange checks it on every anim change
+// while almost nothing is ever queued, so a queued count per AnimData bucket lets that path skip the lookup.
+class QueuedAnimMap
+{
+public:
+	void Push(AnimData* animData, FullAnimGroupID groupId, BSAnimGroupSequence* anim);
+	BSAnimGroupSequence* Pop(AnimData* animData, FullAnimGroupID groupId);
+	bool Contains(AnimData* animData, FullAnimGroupID groupId, BSAnimGroupSequence* anim) const;
+	void RemoveAnimData(AnimData* animData);
+
+	bool MayHaveQueued(AnimData* animData) const
+	{
+		return queuedPerBucket[GetBucket(animData)] != 0;
+	}
+
+private:
+	// ring buffer with room for a few anims inline, moved to the heap if a script queues more
+	class Queue
+	{
+		static constexpr UInt16 kInlineSize = 4;
+		BSAnimGroupSequence* inlineAnims[kInlineSize];
+		std::unique_ptr<BSAnimGroupSequence*[]> heapAnims;
+		UInt16 head = 0;
+		UInt16 count = 0;
+		UInt16 capacity = kInlineSize;
+
+		BSAnimGroupSequence** Data() { return heapAnims ? heapAnims.get() : inlineAnims; }
+		BSAnimGroupSequence* const* Data() const { return heapAnims ? heapAnims.get() : inlineAnims; }
+
+	public:
+		void Push(BSAnimGroupSequence* anim);
+		BSAnimGroupSequence* Pop();
+		bool Contains(BSAnimGroupSequence* anim) const;
+		UInt16 Size() const { return count; }
+	};
+
+	struct Slot
+	{
+		AnimData* animData = nullptr; // nullptr marks an empty slot
+		FullAnimGroupID groupId = 0;
+		Queue queue;
+	};
+
+	static UInt32 GetBucket(AnimData* animData)
+	{
+		return (reinterpret_cast<UInt32>(animData) >> 4) & 0x3F;
+	}
+
+	UInt32 FindSlot(AnimData* animData, FullAnimGroupID groupId) const;
+	void EraseSlot(UInt32 index);
+	void Grow();
+
+	// open addressing with linear probing, capacity is a power of 2
+	std::vector<Slot> slots;
+	UInt32 numUsed = 0;
+	UInt16 queuedPerBucket[0x40] = {};
+};
+
+extern QueuedAnimMap g_queuedReplaceAnims;
 extern std::vector<std::string> g_eachFrameScriptLines;
 extern std::thread g_animFileThread;
 extern std::recursive_mutex g_pollConditionMutex;
@@ -7,6 +7,7 @@
 #include "SafeWrite.h"
 #include "NiObjects.h"
 #include "NiTypes.h"
+#include "profiler.h"
 
 #include <array>
 #include <functional>
@@ -698,6 +699,7 @@ bool NiBlendTransformInterpolator::_Update(float fTime, NiObjectNET* pkInterpTar
 
 bool NiBlendTransformInterpolator::UpdateHooked(float fTime, NiObjectNET* pkInterpTarget, NiQuatTransform& kValue)
 {
+    PROFILE_ZONE("BlendValues");
 #if _DEBUG
     NiQuatTransform kRealValue = kValue;
 #else
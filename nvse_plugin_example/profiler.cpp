@@ -0,0 +1,222 @@
+﻿#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+std::atomic<bool> Profiler::g_enabled = false;
+
+namespace
+{
+    using namespace Profiler;
+
+    // per thread, about 1.5 MB; once full the oldest zones are overwritten
+    constexpr std::uint32_t kRingSize = 1 << 16;
+
+    struct Event
+    {
+        const char* name;
+        Clock::rep start;
+        Clock::rep end; // unused for counters
+        std::uint32_t value;
+        bool isCounter;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(kRingSize);
+        // number of events ever written, wraps around together with the ring since kRingSize divides 2^32
+        std::atomic<std::uint32_t> head = 0;
+        std::uint32_t threadIndex = 0;
+    };
+
+    struct ThreadEvent
+    {
+        std::uint32_t threadIndex;
+        Event event;
+    };
+
+    std::vector<std::shared_ptr<ThreadBuffer>> g_threadBuffers;
+    std::mutex g_threadBuffersMutex;
+    std::atomic<Clock::rep> g_enabledSince = 0;
+    thread_local ThreadBuffer* t_threadBuffer = nullptr;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (!t_threadBuffer)
+        {
+            // owned by g_threadBuffers so zones of threads that have exited can still be exported
+            auto buffer = std::make_shared<ThreadBuffer>();
+            std::unique_lock lock(g_threadBuffersMutex);
+            buffer->threadIndex = g_threadBuffers.size();
+            g_threadBuffers.push_back(buffer);
+            t_threadBuffer = buffer.get();
+        }
+        return t_threadBuffer;
+    }
+
+    // reads other threads' buffers while they may be writing to them, slots overwritten during the copy are dropped
+    std::vector<ThreadEvent> CollectEvents()
+    {
+        std::vector<ThreadEvent> result;
+        const auto since = g_enabledSince.load();
+        std::unique_lock lock(g_threadBuffersMutex);
+        for (const auto& buffer : g_threadBuffers)
+        {
+            const auto head = buffer->head.load(std::memory_order_acquire);
+            const auto count = std::min(head, kRingSize);
+            std::vector<Event> events(count);
+            for (std::uint32_t i = 0; i < count; ++i)
+                events[i] = buffer->events[(head - count + i) % kRingSize];
+            // the writer may also be in the middle of writing the slot after newHead
+            const auto newHead = buffer->head.load(std::memory_order_acquire);
+            const auto overwritten = std::min<std::uint32_t>(newHead - head + 1, kRingSize);
+            const auto firstValid = count + overwritten > kRingSize ? count + overwritten - kRingSize : 0;
+            for (auto i = firstValid; i < count; ++i)
+            {
+                if (events[i].start >= since)
+                    result.push_back(ThreadEvent{ buffer->threadIndex, events[i] });
+            }
+        }
+        return result;
+    }
+
+    double ToMicroseconds(Clock::rep ticks)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::duration(ticks)).count();
+    }
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    if (enabled)
+        g_enabledSince = Clock::now().time_since_epoch().count();
+    g_enabled = enabled;
+}
+
+namespace
+{
+    void Push(const Event& event)
+    {
+        auto* buffer = GetThreadBuffer();
+        const auto head = buffer->head.load(std::memory_order_relaxed);
+        buffer->events[head % kRingSize] = event;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+}
+
+void Profiler::Record(const char* name, Clock::rep start, Clock::rep end)
+{
+    Push(Event{ name, start, end, 0, false });
+}
+
+void Profiler::RecordCounter(const char* name, std::uint32_t value)
+{
+    if (!IsEnabled())
+        return;
+    const auto now = Clock::now().time_since_epoch().count();
+    Push(Event{ name, now, now, value, true });
+}
+
+bool Profiler::ExportChromeTrace(const char* path)
+{
+    const auto events = CollectEvents();
+    std::ofstream stream(path);
+    if (!stream)
+        return false;
+    const auto since = g_enabledSince.load();
+    stream << std::fixed << std::setprecision(3) << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool first = true;
+    for (const auto& [threadIndex, event] : events)
+    {
+        if (!first)
+            stream << ",\n";
+        first = false;
+        // zone names are string literals, nothing to escape
+        stream << R"({"name":")" << event.name << R"(","ph":")" << (event.isCounter ? 'C' : 'X') << R"(","pid":1,"tid":)" << threadIndex
+            << R"(,"ts":)" << ToMicroseconds(event.start - since);
+        if (event.isCounter)
+            stream << R"(,"args":{"value":)" << event.value << "}}";
+        else
+            stream << R"(,"dur":)" << ToMicroseconds(event.end - event.start) << '}';
+    }
+    stream << "]}\n";
+    return static_cast<bool>(stream);
+}
+
+std::vector<ZoneSummary> Profiler::Summarize()
+{
+    // by name rather than pointer, the same literal can have a different address in each translation unit
+    std::map<std::string_view, std::vector<double>> durations;
+    for (const auto& [threadIndex, event] : CollectEvents())
+    {
+        if (!event.isCounter)
+            durations[event.name].push_back(ToMicroseconds(event.end - event.start));
+    }
+
+    std::vector<ZoneSummary> result;
+    for (auto& [name, zoneDurations] : durations)
+    {
+        std::ranges::sort(zoneDurations);
+        const auto percentile = [&](double p)
+        {
+            return zoneDurations[std::min<size_t>(static_cast<size_t>(p * zoneDurations.size()), zoneDurations.size() - 1)];
+        };
+        double total = 0;
+        for (const auto duration : zoneDurations)
+            total += duration;
+        result.push_back(ZoneSummary{
+            .name = name.data(),
+            .count = static_cast<std::uint32_t>(zoneDurations.size()),
+            .totalMs = total / 1000.0,
+            .averageUs = total / zoneDurations.size(),
+            .p50Us = percentile(0.5),
+            .p90Us = percentile(0.9),
+            .p99Us = percentile(0.99),
+            .maxUs = zoneDurations.back()
+        });
+    }
+    std::ranges::sort(result, [](const ZoneSummary& a, const ZoneSummary& b) { return a.totalMs > b.totalMs; });
+    return result;
+}
+
+std::vector<CounterSummary> Profiler::SummarizeCounters()
+{
+    std::map<std::string_view, CounterSummary> counters;
+    for (const auto& [threadIndex, event] : CollectEvents())
+    {
+        if (!event.isCounter)
+            continue;
+        auto& counter = counters.try_emplace(event.name, CounterSummary{ event.name, 0, 0.0, 0 }).first->second;
+        // running mean
+        ++counter.count;
+        counter.average += (event.value - counter.average) / counter.count;
+        counter.max = std::max(counter.max, event.value);
+    }
+    std::vector<CounterSummary> result;
+    for (const auto& [name, counter] : counters)
+        result.push_back(counter);
+    return result;
+}
+
+double Profiler::MeasureZoneOverhead()
+{
+    constexpr auto kIterations = 10000;
+    // recorded into a scratch buffer so the measurement doesn't show up in the recording
+    ThreadBuffer scratch;
+    auto* threadBuffer = t_threadBuffer;
+    t_threadBuffer = &scratch;
+    const auto start = Clock::now();
+    for (auto i = 0; i < kIterations; ++i)
+    {
+        const auto zoneStart = Clock::now().time_since_epoch().count();
+        Record("Profiler overhead", zoneStart, Clock::now().time_since_epoch().count());
+    }
+    const auto end = Clock::now();
+    t_threadBuffer = threadBuffer;
+    return std::chrono::duration<double, std::nano>(end - start).count() / kIterations;
+}
@@ -0,0 +1,241 @@
+﻿#include "script_cache.h"
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "GameData.h"
+#include "GameScript.h"
+#include "hooks.h"
+#include "game_types.h"
+#include "knvse_version.h"
+#include "PluginAPI.h"
+#include "utility.h"
+
+extern NVSEInterface* g_nvseInterface;
+
+namespace
+{
+    const auto* kCachePath = R"(Data\NVSE\Plugins\kNVSE_scripts.cache)";
+
+    struct CacheKey
+    {
+        CompiledScriptCache::Kind kind;
+        std::string_view source;
+
+        bool operator==(const CacheKey& other) const = default;
+    };
+
+    struct CacheKeyHash
+    {
+        std::size_t operator()(const CacheKey& key) const
+        {
+            return std::hash<std::string_view>()(key.source) ^ static_cast<std::size_t>(key.kind);
+        }
+    };
+
+    CompiledScriptCache::CacheFile g_cacheFile;
+    // into g_cacheFile.scripts; keys point to the sources stored there, so it's rebuilt whenever scripts reallocates
+    std::unordered_map<CacheKey, size_t, CacheKeyHash> g_cachedScripts;
+    bool g_cacheDirty = false;
+    std::mutex g_cacheMutex;
+
+    std::vector<std::string> GetLoadOrder()
+    {
+        std::vector<std::string> loadOrder;
+        auto* dataHandler = DataHandler::Get();
+        for (UInt32 i = 0; i < dataHandler->GetActiveModCount(); ++i)
+        {
+            const auto* name = dataHandler->GetNthModName(i);
+            loadOrder.emplace_back(name ? name : "");
+        }
+        return loadOrder;
+    }
+
+    void IndexCachedScripts()
+    {
+        g_cachedScripts.clear();
+        for (size_t i = 0; i < g_cacheFile.scripts.size(); ++i)
+        {
+            const auto& cached = g_cacheFile.scripts[i];
+            g_cachedScripts[CacheKey{ cached.kind, cached.source }] = i;
+        }
+    }
+}
+
+void CompiledScriptCache::Load()
+{
+    if (!g_pluginSettings.cacheCompiledScripts)
+        return;
+    std::unique_lock lock(g_cacheMutex);
+    g_cacheFile = CacheFile{
+        .nvseVersion = g_nvseInterface->nvseVersion,
+        .pluginVersion = VERSION_MAJOR,
+        .loadOrder = GetLoadOrder()
+    };
+    g_cacheDirty = false;
+    std::ifstream stream(kCachePath, std::ios::binary);
+    if (stream)
+    {
+        CacheFile file;
+        if (!Read(stream, file))
+            ERROR_LOG("Compiled script cache is corrupt, scripts will be compiled again");
+        else if (IsValid(file, g_cacheFile.nvseVersion, g_cacheFile.pluginVersion, g_cacheFile.loadOrder))
+            g_cacheFile.scripts = std::move(file.scripts);
+        else
+            LOG("Load order or version changed, compiled script cache discarded");
+    }
+    IndexCachedScripts();
+    LOG(FormatString("Loaded %u compiled scripts from cache", g_cacheFile.scripts.size()));
+}
+
+void CompiledScriptCache::Save()
+{
+    std::unique_lock lock(g_cacheMutex);
+    if (!g_cacheDirty)
+        return;
+    std::ofstream stream(kCachePath, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        ERROR_LOG(FormatString("Failed to open %s for writing", kCachePath));
+        return;
+    }
+    Write(stream, g_cacheFile);
+    g_cacheDirty = false;
+}
+
+Script* CompiledScriptCache::Create(Kind kind, std::string_view source)
+{
+    std::unique_lock lock(g_cacheMutex);
+    const auto iter = g_cachedScripts.find(CacheKey{ kind, source });
+    if (iter == g_cachedScripts.end())
+        return nullptr;
+    const auto& cached = g_cacheFile.scripts[iter->second];
+
+    std::vector<TESForm*> forms;
+    forms.reserve(cached.refs.size());
+    for (const auto& ref : cached.refs)
+    {
+        TESForm* form = nullptr;
+        if (ref.formId)
+        {
+            form = LookupFormByRefID(ref.formId);
+            if (!form || form->typeID != ref.formType)
+                return nullptr;
+        }
+        forms.push_back(form);
+    }
+
+    const auto wasAssigningFormIDs = DataHandler::Get()->GetAssignFormIDs();
+    if (wasAssigningFormIDs)
+        DataHandler::Get()->SetAssignFormIDs(false);
+    auto script = MakeUnique<Script, 0x5AA0F0, 0x5AA1A0>();
+    if (wasAssigningFormIDs)
+        DataHandler::Get()->SetAssignFormIDs(true);
+
+    script->info.unk0 = cached.unk0;
+    script->info.numRefs = cached.numRefs;
+    script->info.dataLength = cached.data.size();
+    script->info.varCount = cached.varCount;
+    script->info.type = cached.type;
+    script->info.compiled = cached.compiled;
+    script->info.unk13 = cached.unk13;
+    script->data = FormHeap_Allocate(cached.data.size());
+    std::memcpy(script->data, cached.data.data(), cached.data.size());
+
+    // lists are built with the game heap, the way the compiler does, so the game's destructor frees them
+    Script::RefListEntry* refEntry = nullptr;
+    for (size_t i = 0; i < cached.refs.size(); ++i)
+    {
+        auto* var = static_cast<Script::RefVariable*>(FormHeap_Allocate(sizeof(Script::RefVariable)));
+        std::memset(var, 0, sizeof(Script::RefVariable));
+        var->name.Set(cached.refs[i].name.c_str());
+        var->form = forms[i];
+        var->varIdx = cached.refs[i].varIdx;
+        if (!refEntry)
+            refEntry = &script->refList;
+        else
+        {
+            auto* next = static_cast<Script::RefListEntry*>(FormHeap_Allocate(sizeof(Script::RefListEntry)));
+            refEntry->next = next;
+            refEntry = next;
+        }
+        refEntry->var = var;
+        refEntry->next = nullptr;
+    }
+
+    Script::VarInfoEntry* varEntry = nullptr;
+    for (const auto& cachedVar : cached.vars)
+    {
+        auto* var = static_cast<VariableInfo*>(FormHeap_Allocate(sizeof(VariableInfo)));
+        std::memset(var, 0, sizeof(VariableInfo));
+        var->idx = cachedVar.idx;
+        var->type = cachedVar.type;
+        var->name.Set(cachedVar.name.c_str());
+        if (!varEntry)
+            varEntry = &script->varList;
+        else
+        {
+            auto* next = static_cast<Script::VarInfoEntry*>(FormHeap_Allocate(sizeof(Script::VarInfoEntry)));
+            varEntry->next = next;
+            varEntry = next;
+        }
+        varEntry->data = var;
+        varEntry->next = nullptr;
+    }
+    return script.release();
+}
+
+void CompiledScriptCache::Add(Kind kind, std::string_view source, Script* script)
+{
+    if (!g_pluginSettings.cacheCompiledScripts)
+        return;
+    std::unique_lock lock(g_cacheMutex);
+    if (g_cachedScripts.contains(CacheKey{ kind, source }))
+        return;
+    CachedScript cached{
+        .kind = kind,
+        .source = std::string(source),
+        .unk0 = script->info.unk0,
+        .numRefs = script->info.numRefs,
+        .varCount = script->info.varCount,
+        .type = script->info.type,
+        .compiled = script->info.compiled,
+        .unk13 = script->info.unk13
+    };
+    const auto* data = static_cast<const UInt8*>(script->data);
+    cached.data.assign(data, data + script->info.dataLength);
+    for (auto* entry = &script->refList; entry; entry = entry->next)
+    {
+        auto* var = entry->var;
+        if (!var)
+            continue;
+        // temporary forms get a new form ID every game start
+        if (var->form && var->form->refID >> 24 == 0xFF)
+            return;
+        cached.refs.push_back(CachedRef{
+            .formId = var->form ? var->form->refID : 0,
+            .formType = var->form ? var->form->typeID : static_cast<UInt8>(0),
+            .varIdx = var->varIdx,
+            .name = var->name.CStr() ? var->name.CStr() : ""
+        });
+    }
+    for (auto* entry = &script->varList; entry; entry = entry->next)
+    {
+        auto* var = entry->data;
+        if (!var)
+            continue;
+        cached.vars.push_back(CachedVar{
+            .idx = var->idx,
+            .type = var->type,
+            .name = var->name.CStr() ? var->name.CStr() : ""
+        });
+    }
+    const auto capacity = g_cacheFile.scripts.capacity();
+    g_cacheFile.scripts.push_back(std::move(cached));
+    if (g_cacheFile.scripts.capacity() != capacity)
+        IndexCachedScripts();
+    else
+        g_cachedScripts.emplace(CacheKey{ kind, g_cacheFile.scripts.back().source }, g_cacheFile.scripts.size() - 1);
+    g_cacheDirty = true;
+}
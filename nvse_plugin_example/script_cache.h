@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <string_view>
+
+#include "script_cache_format.h"
+
+class Script;
+
+// Compiled condition and scriptLine scripts, saved next to the plugin so unchanged scripts don't have to be compiled
+// again on the next game start. The file is thrown away as a whole when the load order or the xNVSE/kNVSE version
+// changes, since the compiled data refers to forms by load order dependent form ID.
+namespace CompiledScriptCache
+{
+    // reads the cache file, call once the load order is known
+    void Load();
+    // writes the cache file if scripts were added since it was last read or written
+    void Save();
+    // new script built from the cached compiled data of source, nullptr if there is none or its forms don't resolve
+    Script* Create(Kind kind, std::string_view source);
+    void Add(Kind kind, std::string_view source, Script* script);
+}
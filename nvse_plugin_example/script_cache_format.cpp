@@ -0,0 +1,157 @@
+﻿#include "script_cache_format.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+namespace
+{
+    constexpr std::uint32_t kMagic = 0x4B534331; // 'KSC1'
+    constexpr std::uint32_t kFormatVersion = 1;
+    // anything above these is a corrupt file rather than a script
+    constexpr std::uint32_t kMaxCount = 0x100000;
+    constexpr std::uint32_t kMaxStringLength = 0x10000;
+
+    template <typename T>
+    void WriteValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WriteString(std::ostream& stream, std::string_view str)
+    {
+        WriteValue(stream, static_cast<std::uint32_t>(str.size()));
+        stream.write(str.data(), str.size());
+    }
+
+    template <typename T>
+    bool ReadValue(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    bool ReadCount(std::istream& stream, std::uint32_t& count, std::uint32_t max = kMaxCount)
+    {
+        return ReadValue(stream, count) && count <= max;
+    }
+
+    bool ReadString(std::istream& stream, std::string& str)
+    {
+        std::uint32_t size;
+        if (!ReadCount(stream, size, kMaxStringLength))
+            return false;
+        str.resize(size);
+        return static_cast<bool>(stream.read(str.data(), size));
+    }
+
+    bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y)
+        {
+            return std::tolower(x) == std::tolower(y);
+        });
+    }
+}
+
+bool CompiledScriptCache::Read(std::istream& stream, CacheFile& file)
+{
+    std::uint32_t magic, formatVersion, numMods, numScripts;
+    if (!ReadValue(stream, magic) || magic != kMagic || !ReadValue(stream, formatVersion) || formatVersion != kFormatVersion)
+        return false;
+    if (!ReadValue(stream, file.nvseVersion) || !ReadValue(stream, file.pluginVersion) || !ReadCount(stream, numMods, 0x100))
+        return false;
+    file.loadOrder.resize(numMods);
+    for (auto& mod : file.loadOrder)
+    {
+        if (!ReadString(stream, mod))
+            return false;
+    }
+    if (!ReadCount(stream, numScripts))
+        return false;
+    file.scripts.resize(numScripts);
+    for (auto& script : file.scripts)
+    {
+        std::uint8_t kind;
+        std::uint32_t dataLength, numRefs, numVars;
+        if (!ReadValue(stream, kind) || kind > static_cast<std::uint8_t>(Kind::ScriptLine) || !ReadString(stream, script.source))
+            return false;
+        script.kind = static_cast<Kind>(kind);
+        if (!ReadValue(stream, script.unk0) || !ReadValue(stream, script.numRefs) || !ReadValue(stream, script.varCount)
+            || !ReadValue(stream, script.type) || !ReadValue(stream, script.compiled) || !ReadValue(stream, script.unk13))
+            return false;
+        if (!ReadCount(stream, dataLength))
+            return false;
+        script.data.resize(dataLength);
+        if (!stream.read(reinterpret_cast<char*>(script.data.data()), dataLength))
+            return false;
+        if (!ReadCount(stream, numRefs))
+            return false;
+        script.refs.resize(numRefs);
+        for (auto& ref : script.refs)
+        {
+            if (!ReadValue(stream, ref.formId) || !ReadValue(stream, ref.formType) || !ReadValue(stream, ref.varIdx) || !ReadString(stream, ref.name))
+                return false;
+        }
+        if (!ReadCount(stream, numVars))
+            return false;
+        script.vars.resize(numVars);
+        for (auto& var : script.vars)
+        {
+            if (!ReadValue(stream, var.idx) || !ReadValue(stream, var.type) || !ReadString(stream, var.name))
+                return false;
+        }
+    }
+    return true;
+}
+
+void CompiledScriptCache::Write(std::ostream& stream, const CacheFile& file)
+{
+    WriteValue(stream, kMagic);
+    WriteValue(stream, kFormatVersion);
+    WriteValue(stream, file.nvseVersion);
+    WriteValue(stream, file.pluginVersion);
+    WriteValue(stream, static_cast<std::uint32_t>(file.loadOrder.size()));
+    for (const auto& mod : file.loadOrder)
+        WriteString(stream, mod);
+    WriteValue(stream, static_cast<std::uint32_t>(file.scripts.size()));
+    for (const auto& script : file.scripts)
+    {
+        WriteValue(stream, static_cast<std::uint8_t>(script.kind));
+        WriteString(stream, script.source);
+        WriteValue(stream, script.unk0);
+        WriteValue(stream, script.numRefs);
+        WriteValue(stream, script.varCount);
+        WriteValue(stream, script.type);
+        WriteValue(stream, script.compiled);
+        WriteValue(stream, script.unk13);
+        WriteValue(stream, static_cast<std::uint32_t>(script.data.size()));
+        stream.write(reinterpret_cast<const char*>(script.data.data()), script.data.size());
+        WriteValue(stream, static_cast<std::uint32_t>(script.refs.size()));
+        for (const auto& ref : script.refs)
+        {
+            WriteValue(stream, ref.formId);
+            WriteValue(stream, ref.formType);
+            WriteValue(stream, ref.varIdx);
+            WriteString(stream, ref.name);
+        }
+        WriteValue(stream, static_cast<std::uint32_t>(script.vars.size()));
+        for (const auto& var : script.vars)
+        {
+            WriteValue(stream, var.idx);
+            WriteValue(stream, var.type);
+            WriteString(stream, var.name);
+        }
+    }
+}
+
+bool CompiledScriptCache::IsValid(const CacheFile& file, std::uint32_t nvseVersion, std::uint32_t pluginVersion, const std::vector<std::string>& loadOrder)
+{
+    if (file.nvseVersion != nvseVersion || file.pluginVersion != pluginVersion || file.loadOrder.size() != loadOrder.size())
+        return false;
+    for (size_t i = 0; i < loadOrder.size(); ++i)
+    {
+        if (!EqualsIgnoreCase(file.loadOrder[i], loadOrder[i]))
+            return false;
+    }
+    return true;
+}
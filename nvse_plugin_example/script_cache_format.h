@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// On-disk format of the compiled script cache (see script_cache.h). Kept free of game types and Windows headers so it
+// can be built and tested on its own, see tests/script_cache_format_test.cpp.
+namespace CompiledScriptCache
+{
+    enum class Kind : std::uint8_t
+    {
+        Condition, ScriptLine
+    };
+
+    struct CachedRef
+    {
+        std::uint32_t formId = 0; // 0 for ref variables without a form
+        std::uint8_t formType = 0;
+        std::uint32_t varIdx = 0;
+        std::string name;
+    };
+
+    struct CachedVar
+    {
+        std::uint32_t idx = 0;
+        std::uint8_t type = 0;
+        std::string name;
+    };
+
+    struct CachedScript
+    {
+        Kind kind = Kind::Condition;
+        std::string source;
+        // Script::ScriptInfo
+        std::uint32_t unk0 = 0;
+        std::uint32_t numRefs = 0;
+        std::uint32_t varCount = 0;
+        std::uint16_t type = 0;
+        bool compiled = false;
+        std::uint8_t unk13 = 0;
+        std::vector<std::uint8_t> data;
+        std::vector<CachedRef> refs;
+        std::vector<CachedVar> vars;
+    };
+
+    struct CacheFile
+    {
+        std::uint32_t nvseVersion = 0;
+        std::uint32_t pluginVersion = 0;
+        std::vector<std::string> loadOrder;
+        std::vector<CachedScript> scripts;
+    };
+
+    // false if the stream isn't a complete cache file of the current format version
+    bool Read(std::istream& stream, CacheFile& file);
+    void Write(std::ostream& stream, const CacheFile& file);
+    // whether file was written by the same xNVSE and kNVSE versions for the same load order, plugin names compared
+    // case-insensitively
+    bool IsValid(const CacheFile& file, std::uint32_t nvseVersion, std::uint32_t pluginVersion, const std::vector<std::string>& loadOrder);
+}
@@ -8,6 +8,9 @@ class SequenceExtraData
 public:
     bool needsStoreTargets = false;
     std::unique_ptr<AdditiveSequenceMetadata> additiveMetadata = nullptr;
+    // see AdditiveManager::GetBoneBindings, only valid while the skeleton index generation matches
+    std::vector<NiAVObject*> boneBindings;
+    UInt32 boneBindingsGeneration = 0;
 };
 
 class SequenceExtraDatas
@@ -0,0 +1,192 @@
+﻿#include "../directory_listing_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int g_failures = 0;
+    int g_scans = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // Stand-in for FileFinder::FindFiles: sorted file names in the folder, counted so tests can tell a hit from a rescan
+    DirectoryListingCache::CreateList Scan(const fs::path& folder)
+    {
+        return [folder]
+        {
+            ++g_scans;
+            std::vector<std::string> files;
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(folder, ec))
+                files.push_back(entry.path().filename().string());
+            std::sort(files.begin(), files.end());
+            return files;
+        };
+    }
+
+    void Touch(const fs::path& path)
+    {
+        std::ofstream(path) << "kf";
+    }
+
+    // timestamps can be coarse, move the folder's mtime explicitly so a change is always visible
+    void BumpWriteTime(const fs::path& folder)
+    {
+        fs::last_write_time(folder, fs::last_write_time(folder) + std::chrono::seconds(1));
+    }
+
+    void TestNormalizePath()
+    {
+        using DirectoryListingCache::NormalizePath;
+        Check(NormalizePath("Data/Meshes//Characters\\\\_Male/*.KF") == "data\\meshes\\characters\\_male\\*.kf", "separators and case are normalized");
+        Check(NormalizePath("") == "", "empty path stays empty");
+        Check(NormalizePath("\\\\") == "\\", "separator run collapses to one");
+    }
+
+    void TestLooseFolderWriteTime(const fs::path& root)
+    {
+        using DirectoryListingCache::GetLooseFolderWriteTime;
+        const auto folder = root / "anims";
+        const auto time = fs::last_write_time(folder);
+        Check(GetLooseFolderWriteTime(folder.string()) == time, "folder path gives its own time");
+        Check(GetLooseFolderWriteTime((folder / "*.kf").string()) == time, "wildcard component is stripped");
+        Check(GetLooseFolderWriteTime(DirectoryListingCache::NormalizePath((folder / "*.kf").string())) == time, "normalized path finds the folder");
+        Check(GetLooseFolderWriteTime((root / "missing" / "*.kf").string()) == fs::file_time_type::min(), "missing folder gives min()");
+    }
+
+    void TestRescanOnWriteTimeChange(const fs::path& root)
+    {
+        const auto folder = root / "anims";
+        const auto search = (folder / "*.kf").string();
+        g_scans = 0;
+
+        const auto first = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 1 && first->size() == 1, "first request scans");
+        const auto second = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 1 && second == first, "unchanged folder is a hit");
+
+        Touch(folder / "b.kf");
+        BumpWriteTime(folder);
+        const auto added = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 2 && added->size() == 2, "added file triggers a rescan");
+        Check(first->size() == 1, "list handed out earlier is unchanged");
+
+        fs::rename(folder / "b.kf", folder / "c.kf");
+        BumpWriteTime(folder);
+        const auto renamed = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 3 && renamed->size() == 2 && renamed->back() == "c.kf", "renamed file triggers a rescan");
+
+        fs::remove(folder / "c.kf");
+        BumpWriteTime(folder);
+        const auto removed = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 4 && removed->size() == 1, "removed file triggers a rescan");
+        DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 4, "rescanned listing is a hit again");
+    }
+
+    void TestMissingFolderAppearing(const fs::path& root)
+    {
+        const auto folder = root / "later";
+        const auto search = (folder / "*.kf").string();
+        g_scans = 0;
+
+        const auto missing = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 1 && missing->empty(), "missing folder is cached as empty");
+
+        fs::create_directory(folder);
+        Touch(folder / "a.kf");
+        const auto created = DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 2 && created->size() == 1, "created folder triggers a rescan");
+    }
+
+    void TestForceRefresh(const fs::path& root)
+    {
+        const auto folder = root / "anims";
+        const auto search = (folder / "*.kf").string();
+        DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        g_scans = 0;
+
+        DirectoryListingCache::GetFolderListing(search, "", 0, true, Scan(folder));
+        Check(g_scans == 1, "forced refresh rescans an unchanged folder");
+        DirectoryListingCache::GetFolderListing(search, "", 0, false, Scan(folder));
+        Check(g_scans == 1, "listing stored by a forced refresh is a hit");
+    }
+
+    void TestKeyNormalization(const fs::path& root)
+    {
+        const auto folder = root / "anims";
+        const auto search = (folder / "*.kf").string();
+        DirectoryListingCache::GetFolderListing(search, "Rename", 0, false, Scan(folder));
+        g_scans = 0;
+
+        std::string variant = search;
+        std::replace(variant.begin(), variant.end(), '/', '\\');
+        variant.insert(variant.find("anims"), "\\");
+        std::transform(variant.begin(), variant.end(), variant.begin(), [](char c) { return c == 'k' ? 'K' : c; });
+        DirectoryListingCache::GetFolderListing(variant, "RENAME", 0, false, Scan(folder));
+        Check(g_scans == 0, "case, separator style and separator runs share an entry");
+
+        DirectoryListingCache::GetFolderListing(search, "Rename", 1, false, Scan(folder));
+        Check(g_scans == 1, "archive type is part of the key");
+        DirectoryListingCache::GetFolderListing(search, "other", 0, false, Scan(folder));
+        Check(g_scans == 2, "rename directory is part of the key");
+    }
+
+    void TestArchiveListing()
+    {
+        g_scans = 0;
+        const auto list = [] { ++g_scans; return std::vector<std::string>{ "meshes\\a.kf" }; };
+        const auto first = DirectoryListingCache::GetArchiveListing("Meshes/Characters", list);
+        const auto second = DirectoryListingCache::GetArchiveListing("meshes\\characters\\", list);
+        Check(g_scans == 2 && first != second, "trailing separator is a different key");
+        DirectoryListingCache::GetArchiveListing("MESHES\\\\CHARACTERS", list);
+        Check(g_scans == 2, "archive listing is kept for the session");
+
+        DirectoryListingCache::Clear();
+        DirectoryListingCache::GetArchiveListing("meshes/characters", list);
+        Check(g_scans == 3, "clear drops archive listings");
+        Check(first->size() == 1, "list handed out before clear stays valid");
+    }
+}
+
+int main()
+{
+    // paths go through NormalizePath, which lowercases them, so the tree must not need uppercase on a case-sensitive system
+    const auto root = fs::temp_directory_path() / "knvse_directory_listing_cache_test";
+    const auto rootString = root.string();
+    if (std::any_of(rootString.begin(), rootString.end(), [](unsigned char c) { return std::isupper(c); }))
+    {
+        std::printf("FAILED: temp directory %s has uppercase characters\n", rootString.c_str());
+        return 1;
+    }
+    fs::remove_all(root);
+    fs::create_directories(root / "anims");
+    Touch(root / "anims" / "a.kf");
+
+    TestNormalizePath();
+    TestLooseFolderWriteTime(root);
+    TestRescanOnWriteTimeChange(root);
+    TestMissingFolderAppearing(root);
+    TestForceRefresh(root);
+    TestKeyNormalization(root);
+    TestArchiveListing();
+
+    fs::remove_all(root);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+﻿#include "../lru_cache.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // Stand-in for NiFixedString: strings are interned while referenced and compared by address, and a freed string's
+    // address can be handed out again for different text
+    class StringTable
+    {
+    public:
+        using Handle = std::shared_ptr<const std::string>;
+
+        Handle Add(const std::string& str)
+        {
+            for (const auto& weak : strings)
+            {
+                if (auto handle = weak.lock(); handle && *handle == str)
+                    return handle;
+            }
+            auto handle = std::make_shared<const std::string>(str);
+            strings.push_back(handle);
+            return handle;
+        }
+
+    private:
+        std::vector<std::weak_ptr<const std::string>> strings;
+    };
+
+    struct PoseKey
+    {
+        StringTable::Handle sequenceName;
+        float timePoint;
+        std::uint32_t layoutHash;
+
+        bool operator==(const PoseKey& other) const
+        {
+            return sequenceName == other.sequenceName && timePoint == other.timePoint && layoutHash == other.layoutHash;
+        }
+    };
+
+    struct PoseKeyHash
+    {
+        std::size_t operator()(const PoseKey& key) const
+        {
+            return std::hash<const void*>()(key.sequenceName.get()) ^ std::hash<float>()(key.timePoint) << 1 ^ key.layoutHash;
+        }
+    };
+
+    using Pose = std::vector<float>;
+    using PoseCache = LruCache<PoseKey, std::shared_ptr<const Pose>, PoseKeyHash, 256>;
+
+    // deterministic stand-in for sampling the reference sequence's interpolators
+    Pose ComputePose(const std::string& sequenceName, float timePoint, std::uint32_t layoutHash)
+    {
+        Pose pose;
+        std::uint32_t seed = layoutHash;
+        for (const char c : sequenceName)
+            seed = seed * 31 + c;
+        for (int i = 0; i < 8; ++i)
+            pose.push_back(static_cast<float>(seed % 1000 + i) * timePoint);
+        return pose;
+    }
+
+    std::shared_ptr<const Pose> GetPose(PoseCache& cache, const PoseKey& key)
+    {
+        if (auto pose = cache.Get(key))
+            return pose;
+        auto pose = std::make_shared<const Pose>(ComputePose(*key.sequenceName, key.timePoint, key.layoutHash));
+        cache.Add(key, pose);
+        return pose;
+    }
+
+    void TestMatchesFreshPoses()
+    {
+        PoseCache cache;
+        StringTable strings;
+        std::vector<StringTable::Handle> names;
+        for (int i = 0; i < 40; ++i)
+            names.push_back(strings.Add("Sequence" + std::to_string(i)));
+
+        std::mt19937 rng(1);
+        std::unordered_set<std::uint32_t> requested;
+        constexpr std::uint32_t kNumRequests = 50000;
+        for (std::uint32_t i = 0; i < kNumRequests; ++i)
+        {
+            // a few hot sequences so there are hits as well as evictions
+            const std::uint32_t nameIdx = rng() % 2 ? rng() % 4 : rng() % names.size();
+            const std::uint32_t timeIdx = rng() % 10, layoutHash = rng() % 4;
+            const PoseKey key{ names[nameIdx], timeIdx * 0.25f, layoutHash };
+            requested.insert(nameIdx * 100 + timeIdx * 10 + layoutHash);
+            const auto pose = GetPose(cache, key);
+            if (*pose != ComputePose(*names[nameIdx], key.timePoint, layoutHash))
+            {
+                Check(false, "cached pose matches freshly computed pose");
+                break;
+            }
+        }
+        Check(cache.Size() == 256, "cache bounded");
+        const auto stats = cache.Clear();
+        Check(stats.hits + stats.misses == kNumRequests, "every lookup counted");
+        Check(stats.hits > kNumRequests / 4 && stats.evictions > 0, "hits and evictions");
+        Check(stats.misses - stats.evictions == 256, "evictions keep the cache full");
+        Check(requested.size() > 256, "more keys than fit");
+        Check(cache.Size() == 0 && cache.Clear().hits == 0, "clear resets");
+    }
+
+    void TestEvictsLeastRecentlyUsed()
+    {
+        PoseCache cache;
+        StringTable strings;
+        const auto name = strings.Add("Idle");
+        for (std::uint32_t i = 0; i < 256; ++i)
+            cache.Add(PoseKey{ name, 0, i }, std::make_shared<const Pose>(1, static_cast<float>(i)));
+        Check(cache.Get(PoseKey{ name, 0, 0 }) != nullptr, "oldest entry present before eviction");
+        cache.Add(PoseKey{ name, 0, 256 }, std::make_shared<const Pose>());
+        Check(cache.Get(PoseKey{ name, 0, 0 }) != nullptr, "recently used entry kept");
+        Check(cache.Get(PoseKey{ name, 0, 1 }) == nullptr, "least recently used entry evicted");
+
+        cache.Add(PoseKey{ name, 0, 0 }, std::make_shared<const Pose>(1, -1.0f));
+        const auto replaced = cache.Get(PoseKey{ name, 0, 0 });
+        Check(replaced && replaced->front() == -1.0f, "add replaces an existing entry");
+    }
+
+    void TestNameReuse()
+    {
+        PoseCache cache;
+        StringTable strings;
+        auto walk = strings.Add("Walk");
+        const auto* walkAddress = walk.get();
+        const auto walkPose = GetPose(cache, PoseKey{ walk, 1.0f, 0 });
+        walk.reset();
+
+        // the cached key still references "Walk", so it stays interned and "Run" can't take its address
+        const auto run = strings.Add("Run");
+        Check(run.get() != walkAddress, "cached name not reused");
+        Check(*GetPose(cache, PoseKey{ run, 1.0f, 0 }) == ComputePose("Run", 1.0f, 0), "other sequence gets its own pose");
+        Check(*GetPose(cache, PoseKey{ strings.Add("Walk"), 1.0f, 0 }) == *walkPose, "same name still hits");
+    }
+}
+
+int main()
+{
+    TestMatchesFreshPoses();
+    TestEvictsLeastRecentlyUsed();
+    TestNameReuse();
+    if (g_failures)
+        std::printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+﻿#include "../profiler.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // see profiler.cpp
+    constexpr std::uint32_t kRingSize = 1 << 16;
+
+    using Profiler::Clock;
+
+    Clock::rep Now()
+    {
+        return Clock::now().time_since_epoch().count();
+    }
+
+    Clock::rep Microseconds(std::uint32_t us)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(us)).count();
+    }
+
+    // recording starts after everything already in the buffers, those are left out of summaries and traces
+    void Restart()
+    {
+        Profiler::SetEnabled(false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        Profiler::SetEnabled(true);
+    }
+
+    const Profiler::ZoneSummary* FindZone(const std::vector<Profiler::ZoneSummary>& zones, std::string_view name)
+    {
+        for (const auto& zone : zones)
+        {
+            if (zone.name == name)
+                return &zone;
+        }
+        return nullptr;
+    }
+
+    size_t CountOccurrences(const std::string& haystack, std::string_view needle)
+    {
+        size_t count = 0;
+        for (auto pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + needle.size()))
+            ++count;
+        return count;
+    }
+
+    void TestThreadsAndSummary()
+    {
+        Restart();
+        constexpr int kNumThreads = 4;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kNumThreads; ++t)
+        {
+            threads.emplace_back([t]
+            {
+                // 1 to 100 us, each thread once
+                for (std::uint32_t us = 1; us <= 100; ++us)
+                {
+                    const auto start = Now();
+                    Profiler::Record("Work", start, start + Microseconds(us));
+                }
+                const auto start = Now();
+                Profiler::Record(t % 2 ? "Odd" : "Even", start, start + Microseconds(1000));
+                PROFILE_ZONE("Scoped");
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        Profiler::RecordCounter("Counter", 4);
+        Profiler::RecordCounter("Counter", 10);
+        Profiler::RecordCounter("Counter", 1);
+
+        // threads have exited, their zones are still there
+        const auto zones = Profiler::Summarize();
+        const auto* work = FindZone(zones, "Work");
+        Check(work && work->count == 100 * kNumThreads, "zones of every thread counted");
+        Check(work && std::abs(work->averageUs - 50.5) < 0.01 && std::abs(work->totalMs - 20.2) < 0.01, "average and total");
+        Check(work && std::abs(work->p50Us - 51) < 0.01 && std::abs(work->p90Us - 91) < 0.01, "percentiles");
+        Check(work && std::abs(work->p99Us - 100) < 0.01 && std::abs(work->maxUs - 100) < 0.01, "p99 and max");
+        const auto* odd = FindZone(zones, "Odd");
+        const auto* even = FindZone(zones, "Even");
+        Check(odd && even && odd->count == 2 && even->count == 2, "zones by name");
+        Check(!zones.empty() && std::string_view(zones.front().name) == "Work", "sorted by total time");
+        const auto* scoped = FindZone(zones, "Scoped");
+        Check(scoped && scoped->count == kNumThreads, "scoped zones recorded");
+        Check(!FindZone(zones, "Counter"), "counters left out of zones");
+
+        const auto counters = Profiler::SummarizeCounters();
+        Check(counters.size() == 1 && counters[0].count == 3 && std::abs(counters[0].average - 5) < 0.01 && counters[0].max == 10,
+            "counter summary");
+
+        const auto path = (std::filesystem::temp_directory_path() / "knvse_profiler_test.json").string();
+        Check(Profiler::ExportChromeTrace(path.c_str()), "trace written");
+        std::ifstream stream(path);
+        std::stringstream contents;
+        contents << stream.rdbuf();
+        const auto trace = contents.str();
+        std::filesystem::remove(path);
+        Check(trace.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[{)") && trace.ends_with("}]}\n"), "trace framing");
+        Check(CountOccurrences(trace, R"("ph":"X")") == 100 * kNumThreads + kNumThreads * 2, "complete event per zone");
+        Check(CountOccurrences(trace, R"({"name":"Counter","ph":"C")") == 3 && CountOccurrences(trace, R"("args":{"value":10})") == 1,
+            "counter events");
+        std::set<std::string> threadIds;
+        for (auto pos = trace.find(R"("tid":)"); pos != std::string::npos; pos = trace.find(R"("tid":)", pos + 1))
+            threadIds.insert(trace.substr(pos + 6, trace.find(',', pos) - pos - 6));
+        Check(threadIds.size() == kNumThreads + 1, "one track per thread");
+        Check(CountOccurrences(trace, "{") == CountOccurrences(trace, "}"), "balanced braces");
+    }
+
+    void TestRingWraparound()
+    {
+        Restart();
+        std::thread([]
+        {
+            // the oldest zones are overwritten once the ring is full
+            for (std::uint32_t i = 0; i < kRingSize + 1000; ++i)
+            {
+                const auto start = Now();
+                Profiler::Record("Wrapped", start, start + Microseconds(i < 1000 ? 500 : 1));
+            }
+        }).join();
+        const auto zones = Profiler::Summarize();
+        const auto* wrapped = FindZone(zones, "Wrapped");
+        // the slot written next may be mid-write when the ring is full, so it's left out too
+        Check(wrapped && wrapped->count == kRingSize - 1, "ring keeps the newest zones");
+        Check(wrapped && std::abs(wrapped->maxUs - 1) < 0.01, "oldest zones overwritten");
+    }
+
+    void TestRestartDiscards()
+    {
+        Restart();
+        const auto start = Now();
+        Profiler::Record("Before", start, start + Microseconds(1));
+        Restart();
+        Check(Profiler::Summarize().empty(), "enabling discards earlier zones");
+
+        Profiler::SetEnabled(false);
+        {
+            PROFILE_ZONE("Disabled");
+        }
+        Profiler::RecordCounter("Disabled counter", 1);
+        Check(!FindZone(Profiler::Summarize(), "Disabled") && Profiler::SummarizeCounters().empty(), "nothing recorded while disabled");
+        Check(Profiler::MeasureZoneOverhead() > 0 && Profiler::Summarize().empty(), "overhead measured off the recording");
+    }
+}
+
+int main()
+{
+    TestThreadsAndSummary();
+    TestRingWraparound();
+    TestRestartDiscards();
+    if (g_failures)
+        std::printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+﻿#include "../script_cache_format.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace CompiledScriptCache;
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    CacheFile MakeFile()
+    {
+        CachedScript condition{
+            .kind = Kind::Condition,
+            .source = "GetAV Health > 10",
+            .unk0 = 1,
+            .numRefs = 1,
+            .varCount = 0,
+            .type = 0x100,
+            .compiled = true,
+            .unk13 = 2,
+            .data = { 0x10, 0x00, 0x20, 0xFF },
+            .refs = { CachedRef{ .formId = 0x0100ABCD, .formType = 0x2A, .varIdx = 0, .name = "" } }
+        };
+        CachedScript scriptLine{
+            .kind = Kind::ScriptLine,
+            .source = std::string(300, 'x'),
+            .varCount = 2,
+            .compiled = true,
+            .data = std::vector<std::uint8_t>(1000, 0x7E),
+            .refs = { CachedRef{ .varIdx = 2, .name = "rTarget" } },
+            .vars = { CachedVar{ .idx = 1, .type = 0, .name = "fValue" }, CachedVar{ .idx = 2, .type = 4, .name = "rTarget" } }
+        };
+        return CacheFile{
+            .nvseVersion = 0x06030000,
+            .pluginVersion = 50,
+            .loadOrder = { "FalloutNV.esm", "kNVSE Test.esp" },
+            .scripts = { condition, scriptLine }
+        };
+    }
+
+    bool SameRefs(const std::vector<CachedRef>& a, const std::vector<CachedRef>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].formId != b[i].formId || a[i].formType != b[i].formType || a[i].varIdx != b[i].varIdx || a[i].name != b[i].name)
+                return false;
+        }
+        return true;
+    }
+
+    bool SameVars(const std::vector<CachedVar>& a, const std::vector<CachedVar>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].idx != b[i].idx || a[i].type != b[i].type || a[i].name != b[i].name)
+                return false;
+        }
+        return true;
+    }
+
+    bool SameScripts(const CachedScript& a, const CachedScript& b)
+    {
+        return a.kind == b.kind && a.source == b.source && a.unk0 == b.unk0 && a.numRefs == b.numRefs
+            && a.varCount == b.varCount && a.type == b.type && a.compiled == b.compiled && a.unk13 == b.unk13
+            && a.data == b.data && SameRefs(a.refs, b.refs) && SameVars(a.vars, b.vars);
+    }
+
+    std::string Serialize(const CacheFile& file)
+    {
+        std::ostringstream stream;
+        Write(stream, file);
+        return stream.str();
+    }
+
+    bool Deserialize(const std::string& bytes, CacheFile& file)
+    {
+        std::istringstream stream(bytes);
+        return Read(stream, file);
+    }
+
+    void TestRoundTrip()
+    {
+        const auto original = MakeFile();
+        CacheFile read;
+        Check(Deserialize(Serialize(original), read), "round trip reads back");
+        Check(read.nvseVersion == original.nvseVersion && read.pluginVersion == original.pluginVersion, "round trip versions");
+        Check(read.loadOrder == original.loadOrder, "round trip load order");
+        Check(read.scripts.size() == original.scripts.size(), "round trip script count");
+        for (size_t i = 0; i < read.scripts.size() && i < original.scripts.size(); ++i)
+            Check(SameScripts(read.scripts[i], original.scripts[i]), "round trip script contents");
+
+        CacheFile empty;
+        Check(Deserialize(Serialize(CacheFile{}), empty) && empty.loadOrder.empty() && empty.scripts.empty(), "round trip empty file");
+    }
+
+    void TestCorruptFiles()
+    {
+        const auto bytes = Serialize(MakeFile());
+        CacheFile file;
+        Check(!Deserialize("", file), "empty stream rejected");
+        for (size_t length = 0; length < bytes.size(); ++length)
+        {
+            CacheFile truncated;
+            if (Deserialize(bytes.substr(0, length), truncated))
+            {
+                Check(false, "truncated file rejected");
+                break;
+            }
+        }
+
+        auto badMagic = bytes;
+        badMagic[0] ^= 0xFF;
+        Check(!Deserialize(badMagic, file), "wrong magic rejected");
+
+        auto badVersion = bytes;
+        badVersion[4] ^= 0xFF;
+        Check(!Deserialize(badVersion, file), "wrong format version rejected");
+
+        // numMods follows magic, format version, xNVSE and kNVSE version
+        auto tooManyMods = bytes;
+        tooManyMods[16] = '\xFF';
+        tooManyMods[17] = '\xFF';
+        Check(!Deserialize(tooManyMods, file), "oversized mod count rejected");
+
+        // kind of the first script follows the script count
+        auto badKind = Serialize(CacheFile{ .scripts = { CachedScript{} } });
+        badKind[24] = 2;
+        Check(!Deserialize(badKind, file), "unknown script kind rejected");
+    }
+
+    void TestIsValid()
+    {
+        const auto file = MakeFile();
+        Check(IsValid(file, file.nvseVersion, file.pluginVersion, file.loadOrder), "same versions and load order valid");
+        Check(IsValid(file, file.nvseVersion, file.pluginVersion, { "falloutnv.ESM", "KNVSE TEST.ESP" }), "load order compared case-insensitively");
+        Check(!IsValid(file, file.nvseVersion + 1, file.pluginVersion, file.loadOrder), "xNVSE version change invalid");
+        Check(!IsValid(file, file.nvseVersion, file.pluginVersion + 1, file.loadOrder), "kNVSE version change invalid");
+        Check(!IsValid(file, file.nvseVersion, file.pluginVersion, { "FalloutNV.esm" }), "removed plugin invalid");
+        Check(!IsValid(file, file.nvseVersion, file.pluginVersion, { "kNVSE Test.esp", "FalloutNV.esm" }), "reordered plugins invalid");
+        Check(!IsValid(file, file.nvseVersion, file.pluginVersion, { "FalloutNV.esm", "kNVSE Test2.esp" }), "renamed plugin invalid");
+    }
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestCorruptFiles();
+    TestIsValid();
+    if (g_failures)
+        std::printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
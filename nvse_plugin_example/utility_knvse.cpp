@@ -3,6 +3,7 @@
 #include "main.h"
 #include "utility.h"
 #include "SafeWrite.h"
+#include "script_cache.h"
 
 std::string ReplaceAll(std::string str, const std::string& from, const std::string& to) {
 	size_t start_pos = 0;
@@ -122,6 +123,11 @@ Script* CompileConditionScript(std::string_view condString)
 	auto [iter, isNew] = g_conditionScripts.emplace(condString, nullptr);
 	if (!isNew)
 		return iter->second;
+	if (auto* cached = CompiledScriptCache::Create(CompiledScriptCache::Kind::Condition, condString))
+	{
+		iter->second = cached;
+		return cached;
+	}
 	ScriptBuffer buffer;
 	const auto wasAssigningFormIDs = DataHandler::Get()->GetAssignFormIDs();
 	if (wasAssigningFormIDs)
@@ -154,6 +160,7 @@ Script* CompileConditionScript(std::string_view condString)
 		return nullptr;
 	}
 	auto* script = condition.release();
+	CompiledScriptCache::Add(CompiledScriptCache::Kind::Condition, condString, script);
 	iter->second = script;
 	return script;
 }
\ No newline at end of file